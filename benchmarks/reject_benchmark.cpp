@@ -0,0 +1,142 @@
+/**
+ * Shadow Daemon -- Web Application Firewall
+ *
+ *   Copyright (C) 2014-2022 Hendrik Buchwald <hb@zecure.org>
+ *
+ * This file is part of Shadow Daemon. Shadow Daemon is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, version 2.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+/**
+ * Measures the cost of answering a flood of requests with bad signatures.
+ *
+ * Every iteration parses a complete frame, checks the signature and encodes
+ * the rejection, just like a connection does. The same loop is repeated with
+ * an exception that is thrown and caught per rejection to show the share of
+ * the unwinding.
+ *
+ * Usage: reject_benchmark [iterations]
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "request_parser.h"
+#include "request_handler.h"
+#include "reply_handler.h"
+#include "shared.h"
+
+namespace {
+    /**
+     * @brief Parse, check and reject one frame with a bad signature.
+     *
+     * @param frame The complete frame
+     * @param profile The profile of the request
+     * @param use_exception Report the rejection with an exception
+     */
+    void reject(const std::string& frame, swd::profile_ptr profile, bool use_exception) {
+        swd::request_ptr request(new swd::request);
+        swd::reply_ptr reply(new swd::reply);
+        swd::request_parser request_parser;
+
+        boost::tribool result;
+        boost::tie(result, boost::tuples::ignore) =
+            request_parser.parse(
+                request,
+                frame.data(),
+                frame.data() + frame.length()
+            );
+
+        request->set_profile(profile);
+
+        swd::request_handler request_handler(request, swd::cache_ptr(), swd::storage_ptr());
+
+        if (!request_handler.valid_signature()) {
+            if (use_exception) {
+                try {
+                    throw std::runtime_error("Bad signature");
+                } catch (const std::runtime_error& e) {
+                    reply->set_status(STATUS_BAD_SIGNATURE);
+                    reply->set_message(e.what());
+                }
+            } else {
+                reply->set_status(STATUS_BAD_SIGNATURE);
+                reply->set_message("Bad signature");
+            }
+        }
+
+        swd::reply_handler reply_handler(reply);
+        reply_handler.encode();
+    }
+
+    /**
+     * @brief Run the flood and print the cost per rejection.
+     *
+     * @param name The name of the variant
+     * @param iterations The number of rejected requests
+     * @param use_exception Report the rejections with exceptions
+     */
+    void run(const std::string& name, int iterations, bool use_exception) {
+        std::string content = "{\"version\":\"2.0.0\",\"client_ip\":\"127.0.0.1\","
+         "\"caller\":\"foo\",\"resource\":\"/bar\",\"input\":{\"GET|a\":\"b\"},\"hashes\":{}}";
+        std::string frame = "1\n" + std::string(64, '0') + "\n" + content + "\n";
+
+        swd::profile_ptr profile(new swd::profile);
+        profile->set_key("foo");
+
+        auto start = std::chrono::steady_clock::now();
+
+        for (int i = 0; i < iterations; i++) {
+            reject(frame, profile, use_exception);
+        }
+
+        auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start
+        );
+
+        std::cout << name << ": " << (duration.count() / iterations)
+         << " ns per rejected request" << std::endl;
+    }
+}
+
+int main(int argc, char** argv) {
+    int iterations = ((argc > 1) ? std::atoi(argv[1]) : 100000);
+
+    if (iterations <= 0) {
+        std::cerr << "Usage: " << argv[0] << " [iterations]" << std::endl;
+        return 1;
+    }
+
+    /* Warm up the allocators and caches first. */
+    run("warmup", (iterations / 10) + 1, false);
+
+    run("status", iterations, false);
+    run("exception", iterations, true);
+
+    return 0;
+}
@@ -0,0 +1,313 @@
+/**
+ * Shadow Daemon -- Web Application Firewall
+ *
+ *   Copyright (C) 2014-2022 Hendrik Buchwald <hb@zecure.org>
+ *
+ * This file is part of Shadow Daemon. Shadow Daemon is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, version 2.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#ifndef ADMISSION_H
+#define ADMISSION_H
+
+#include <atomic>
+#include <chrono>
+#include <list>
+#include <map>
+#include <utility>
+#include <boost/asio.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+namespace swd {
+    /**
+     * @brief Decides if new work is accepted or if load has to be shed.
+     *
+     * The admission control limits the number of concurrent connections and
+     * analyses and it limits the request rate of single sources with token
+     * buckets. If a limit is exceeded the connection is answered right away
+     * without any analysis instead of queueing it, so that an overloaded
+     * daemon does not slow down every client until they time out.
+     *
+     * Limits smaller than zero disable the respective check.
+     */
+    class admission :
+     private boost::noncopyable {
+        public:
+            /**
+             * @brief Set the limits of the admission control.
+             *
+             * @param max_connections The maximum number of concurrent connections
+             * @param max_analyses The maximum number of concurrent analyses
+             * @param rate_limit The number of requests per second per source
+             * @param rate_burst The number of requests a source may send at once
+             * @param max_failures The number of failed requests per minute
+             *  after that a source gets blocked
+             */
+            void set_limits(int max_connections, int max_analyses,
+             int rate_limit, int rate_burst, int max_failures = -1);
+
+            /**
+             * @brief Register a new connection.
+             *
+             * The connection is counted even if it is not admitted, so it
+             * always has to be removed again.
+             *
+             * @param address The address of the shadowd client
+             * @return True if the connection should be processed normally
+             */
+            bool add_connection(const boost::asio::ip::address& address);
+
+            /**
+             * @brief Unregister a connection.
+             */
+            void remove_connection();
+
+            /**
+             * @brief Try to reserve a slot for an analysis.
+             *
+             * @return True if the analysis may start
+             */
+            bool add_analysis();
+
+            /**
+             * @brief Free a reserved analysis slot.
+             */
+            void remove_analysis();
+
+            /**
+             * @brief Count a request of a source that failed the validation.
+             *
+             * @param address The address of the source
+             */
+            void add_failure(const boost::asio::ip::address& address);
+
+            /**
+             * @brief Check if a source failed too often recently.
+             *
+             * Requests of blocked sources are rejected before any database or
+             * crypto work is done.
+             *
+             * @param address The address of the source
+             * @return True if the source is blocked
+             */
+            bool is_blocked(const boost::asio::ip::address& address);
+
+            /**
+             * @brief Count a shed request and decide if it should be logged.
+             *
+             * Shed requests are reported at most once per second, so that an
+             * overload does not also flood the log.
+             *
+             * @return The number of shed requests since the last report or 0
+             *  if it is too early for a new report
+             */
+            unsigned long count_shed();
+
+            /**
+             * @brief Get the number of concurrent connections.
+             *
+             * @return The number of connections
+             */
+            int get_connections() const;
+
+            /**
+             * @brief Get the number of concurrent analyses.
+             *
+             * @return The number of analyses
+             */
+            int get_analyses() const;
+
+        private:
+            /**
+             * @brief Take a token from the bucket of a source.
+             *
+             * @param address The address of the source
+             * @return True if a token was available
+             */
+            bool take_token(const boost::asio::ip::address& address);
+
+            /**
+             * @brief Token bucket of a single source.
+             */
+            struct bucket {
+                /**
+                 * @brief The number of available tokens.
+                 */
+                double tokens;
+
+                /**
+                 * @brief The last time the bucket was refilled.
+                 */
+                std::chrono::steady_clock::time_point last;
+            };
+
+            /**
+             * @brief Buckets of sources ordered from the most to the least recently used.
+             */
+            using bucket_list = std::list<std::pair<boost::asio::ip::address, bucket>>;
+
+            /**
+             * @brief Token buckets with a bounded size.
+             */
+            struct bucket_table {
+                /**
+                 * @brief The buckets in the order of their last access.
+                 */
+                bucket_list entries;
+
+                /**
+                 * @brief The position of the bucket of every source in the list.
+                 */
+                std::map<boost::asio::ip::address, bucket_list::iterator> index;
+            };
+
+            /**
+             * @brief Find and refill the bucket of a source.
+             *
+             * The mutex of the buckets has to be locked by the caller.
+             *
+             * @param buckets The buckets of all sources
+             * @param address The address of the source
+             * @param rate The number of tokens that are added per second
+             * @param burst The size of the bucket
+             * @param create True if a missing bucket should be created
+             * @return The bucket or a null pointer if it does not exist
+             */
+            bucket* get_bucket(bucket_table& buckets,
+             const boost::asio::ip::address& address, double rate, double burst,
+             bool create);
+
+            /**
+             * @brief The maximum number of concurrent connections.
+             */
+            int max_connections_ = -1;
+
+            /**
+             * @brief The maximum number of concurrent analyses.
+             */
+            int max_analyses_ = -1;
+
+            /**
+             * @brief The number of tokens that are added per second.
+             */
+            int rate_limit_ = -1;
+
+            /**
+             * @brief The size of the token buckets.
+             */
+            int rate_burst_ = 0;
+
+            /**
+             * @brief The number of failed requests per minute that is tolerated.
+             */
+            int max_failures_ = -1;
+
+            /**
+             * @brief The number of concurrent connections.
+             */
+            std::atomic<int> connections_{0};
+
+            /**
+             * @brief The number of concurrent analyses.
+             */
+            std::atomic<int> analyses_{0};
+
+            /**
+             * @brief The number of shed requests that were not logged yet.
+             */
+            std::atomic<unsigned long> shed_{0};
+
+            /**
+             * @brief The time of the last report of shed requests in nanoseconds.
+             */
+            std::atomic<long long> shed_reported_{0};
+
+            /**
+             * @brief The token buckets of all sources.
+             */
+            bucket_table buckets_;
+
+            /**
+             * @brief The mutex for the token buckets.
+             */
+            boost::mutex buckets_mutex_;
+
+            /**
+             * @brief The failure buckets of all sources.
+             */
+            bucket_table failures_;
+
+            /**
+             * @brief The mutex for the failure buckets.
+             */
+            boost::mutex failures_mutex_;
+    };
+
+    /**
+     * @brief Admission pointer.
+     */
+    using admission_ptr = boost::shared_ptr<swd::admission>;
+
+    /**
+     * @brief Reserves an analysis slot for the lifetime of the object.
+     */
+    class analysis_slot :
+     private boost::noncopyable {
+        public:
+            /**
+             * @brief Try to reserve an analysis slot.
+             *
+             * @param admission The pointer to the admission object
+             */
+            analysis_slot(swd::admission_ptr admission);
+
+            /**
+             * @brief Free the analysis slot if it was granted.
+             */
+            ~analysis_slot();
+
+            /**
+             * @brief Check if the analysis slot was granted.
+             *
+             * @return True if the analysis may start
+             */
+            bool is_granted() const;
+
+        private:
+            /**
+             * @brief The pointer to the admission object.
+             */
+            swd::admission_ptr admission_;
+
+            /**
+             * @brief The status of the reservation.
+             */
+            bool granted_;
+    };
+}
+
+#endif /* ADMISSION_H */
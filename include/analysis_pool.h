@@ -0,0 +1,163 @@
+/**
+ * Shadow Daemon -- Web Application Firewall
+ *
+ *   Copyright (C) 2014-2022 Hendrik Buchwald <hb@zecure.org>
+ *
+ * This file is part of Shadow Daemon. Shadow Daemon is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, version 2.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#ifndef ANALYSIS_POOL_H
+#define ANALYSIS_POOL_H
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <boost/asio.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/thread.hpp>
+
+namespace swd {
+    /**
+     * @brief Runs the analyses of requests on dedicated threads.
+     *
+     * The io threads of the server only accept connections and read and write
+     * data. The expensive part, i.e. the signature check, the decoding, the
+     * database queries and the scanning, is queued here, so that a slow query
+     * or regular expression can not stall the network handling. Both thread
+     * pools are sized independently.
+     */
+    class analysis_pool :
+     private boost::noncopyable {
+        public:
+            /**
+             * @brief Construct the pool without threads.
+             */
+            analysis_pool();
+
+            /**
+             * @brief Start the worker threads.
+             *
+             * @param thread_pool_size The number of worker threads
+             */
+            void start(std::size_t thread_pool_size);
+
+            /**
+             * @brief Stop the worker threads and wait for them to exit.
+             *
+             * Queued analyses that did not start yet are dropped.
+             */
+            void stop();
+
+            /**
+             * @brief Queue an analysis.
+             *
+             * @param task The function that executes the analysis
+             */
+            void post(const std::function<void()>& task);
+
+            /**
+             * @brief Get the number of analyses that wait for a worker.
+             *
+             * @return The length of the queue
+             */
+            int get_queued() const;
+
+            /**
+             * @brief Get the number of analyses that are executed right now.
+             *
+             * @return The number of busy workers
+             */
+            int get_active() const;
+
+            /**
+             * @brief Get the number of finished analyses.
+             *
+             * @return The number of finished analyses
+             */
+            unsigned long long get_completed() const;
+
+            /**
+             * @brief Get the longest time an analysis had to wait for a worker.
+             *
+             * @return The time in milliseconds
+             */
+            unsigned long long get_max_wait() const;
+
+        private:
+            /**
+             * @brief Execute a queued analysis and update the metrics.
+             *
+             * @param task The function that executes the analysis
+             * @param queued The point in time the analysis was queued
+             */
+            void run(const std::function<void()>& task,
+             std::chrono::steady_clock::time_point queued);
+
+            /**
+             * @brief The io_service that holds the queue.
+             */
+            boost::asio::io_service io_service_;
+
+            /**
+             * @brief Keeps the workers alive while the queue is empty.
+             */
+            std::unique_ptr<boost::asio::io_service::work> work_;
+
+            /**
+             * @brief The worker threads.
+             */
+            boost::thread_group threads_;
+
+            /**
+             * @brief The number of analyses that wait for a worker.
+             */
+            std::atomic<int> queued_{0};
+
+            /**
+             * @brief The number of analyses that are executed right now.
+             */
+            std::atomic<int> active_{0};
+
+            /**
+             * @brief The number of finished analyses.
+             */
+            std::atomic<unsigned long long> completed_{0};
+
+            /**
+             * @brief The longest wait time in milliseconds.
+             */
+            std::atomic<unsigned long long> max_wait_{0};
+    };
+
+    /**
+     * @brief Analysis pool pointer.
+     */
+    using analysis_pool_ptr = boost::shared_ptr<swd::analysis_pool>;
+}
+
+#endif /* ANALYSIS_POOL_H */
@@ -32,8 +32,12 @@
 #ifndef BLACKLIST_H
 #define BLACKLIST_H
 
+#include <string>
+#include <vector>
+
 #include "request.h"
 #include "cache.h"
+#include "scan_pool.h"
 
 namespace swd {
     /**
@@ -45,8 +49,17 @@ namespace swd {
              * @brief Construct the blacklist.
              *
              * @param cache The pointer to the cache object
+             * @param full_scan False if the scan of a parameter in active mode
+             *  may stop as soon as its threshold is exceeded
+             * @param scan_pool The pointer to the pool that splits large requests
+             * @param scan_window The size of the windows long inputs are
+             *  scanned in or -1
+             * @param unbounded_span The assumed match span of filters without
+             *  an upper bound or -1 to scan such filters without windows
              */
-            blacklist(swd::cache_ptr cache);
+            blacklist(swd::cache_ptr cache, bool full_scan = true,
+             swd::scan_pool_ptr scan_pool = swd::scan_pool_ptr(), int scan_window = -1,
+             int unbounded_span = -1);
 
             /**
              * @brief Scan all parameters in the request and add connections to
@@ -57,6 +70,125 @@ namespace swd {
             void scan(const swd::request_ptr& request) const;
 
         private:
+            /**
+             * @brief The buffers for the scan of a parameter.
+             */
+            struct scan_buffers {
+                std::string folded_value;
+                std::string folded_path;
+                std::vector<unsigned int> value_matches;
+                std::vector<unsigned int> path_matches;
+                std::vector<unsigned int> matches;
+            };
+
+            /**
+             * @brief Scan a parameter, add connections to matching filters and
+             *  check its threshold.
+             *
+             * @param request The pointer to the request object
+             * @param filter_set The set of blacklist filters
+             * @param order The order of evaluation or empty for a full scan
+             * @param parameter The pointer to the parameter object
+             * @param buffers The buffers of the calling thread
+             */
+            void scan_parameter(const swd::request_ptr& request,
+             const swd::blacklist_filter_set_ptr& filter_set, const std::vector<unsigned int>& order,
+             const swd::parameter_ptr& parameter, swd::blacklist::scan_buffers& buffers) const;
+
+            /**
+             * @brief Scan a single large parameter with the filters split
+             *  between threads, add connections to matching filters and
+             *  check its threshold.
+             *
+             * @param request The pointer to the request object
+             * @param filter_set The set of blacklist filters
+             * @param order The order of evaluation or empty for a full scan
+             * @param parameter The pointer to the parameter object
+             */
+            void scan_filters(const swd::request_ptr& request,
+             const swd::blacklist_filter_set_ptr& filter_set, const std::vector<unsigned int>& order,
+             const swd::parameter_ptr& parameter) const;
+
+            /**
+             * @brief Scan all parameters of a request in batches with the
+             *  parameters of other requests.
+             *
+             * With an order the value and the path of a parameter skip the
+             * remaining filters as soon as its threshold is exceeded.
+             *
+             * @param request The pointer to the request object
+             * @param filter_set The set of blacklist filters
+             * @param order The order of evaluation or empty for a full scan
+             */
+            void scan_batched(const swd::request_ptr& request,
+             const swd::blacklist_filter_set_ptr& filter_set, const std::vector<unsigned int>& order) const;
+
+            /**
+             * @brief Add connections to matching filters to a parameter and
+             *  check its threshold.
+             *
+             * @param filter_set The set of blacklist filters
+             * @param parameter The pointer to the parameter object
+             * @param threshold The threshold of the parameter
+             * @param matches The indexes of the matching filters
+             */
+            void add_matches(const swd::blacklist_filter_set_ptr& filter_set,
+             const swd::parameter_ptr& parameter, int threshold,
+             const std::vector<unsigned int>& matches) const;
+
+            /**
+             * @brief Get the indexes of all filters of a set that match a string.
+             *
+             * Results for short strings are taken from the scan memo of the
+             * cache if possible.
+             *
+             * @param filter_set The set of blacklist filters
+             * @param input The string that should be tested
+             * @param folded The buffer for the lowercase version of the input
+             * @param matches The sorted indexes of the matching filters
+             */
+            void match(const swd::blacklist_filter_set_ptr& filter_set,
+             const std::string& input, std::string& folded,
+             std::vector<unsigned int>& matches) const;
+
+            /**
+             * @brief Get the indexes of the filters that match the value or the
+             *  path of a parameter until the threshold is exceeded.
+             *
+             * The filters are evaluated in the given order. Results for short
+             * strings are taken from the scan memo and only saved if all
+             * filters were evaluated.
+             *
+             * @param filter_set The set of blacklist filters
+             * @param order The indexes of the filters in the order of evaluation
+             * @param parameter The pointer to the parameter object
+             * @param threshold The threshold of the parameter
+             * @param folded_value The buffer for the lowercase version of the value
+             * @param folded_path The buffer for the lowercase version of the path
+             * @param value_matches The buffer for the indexes that match the value
+             * @param path_matches The buffer for the indexes that match the path
+             * @param matches The sorted indexes of the matching filters
+             */
+            void match_until(const swd::blacklist_filter_set_ptr& filter_set,
+             const std::vector<unsigned int>& order, const swd::parameter_ptr& parameter,
+             int threshold, std::string& folded_value, std::string& folded_path,
+             std::vector<unsigned int>& value_matches, std::vector<unsigned int>& path_matches,
+             std::vector<unsigned int>& matches) const;
+
+            /**
+             * @brief Evaluate a single filter and update its statistics.
+             *
+             * Quarantined filters are skipped unless the input is sampled.
+             *
+             * @param filter The pointer to the blacklist filter
+             * @param input The string that should be tested
+             * @param folded The lowercase version of the input
+             * @param complete Set to false if the filter is skipped
+             * @return True if the filter matches or if the engine gives up
+             */
+            bool evaluate(const swd::blacklist_filter_ptr& filter, const std::string& input,
+             const std::string& folded, bool& complete) const;
+
             /**
              * @brief If available get threshold from blacklist rule, otherwise from profile.
              *
@@ -70,6 +202,28 @@ namespace swd {
              * @brief The pointer to the cache object.
              */
             swd::cache_ptr cache_;
+
+            /**
+             * @brief False if the scan may stop once the verdict is final.
+             */
+            bool full_scan_;
+
+            /**
+             * @brief The pointer to the pool that splits large requests.
+             */
+            swd::scan_pool_ptr scan_pool_;
+
+            /**
+             * @brief The size of the scan windows or zero if inputs are scanned
+             *  as a whole.
+             */
+            std::size_t scan_window_;
+
+            /**
+             * @brief The assumed match span of unbounded filters or zero if
+             *  they scan inputs as a whole.
+             */
+            std::size_t unbounded_span_;
     };
 }
 
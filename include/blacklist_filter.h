@@ -32,11 +32,14 @@
 #ifndef BLACKLIST_FILTER_H
 #define BLACKLIST_FILTER_H
 
+#include <set>
 #include <vector>
 #include <string>
-#include <boost/regex.hpp>
 #include <boost/shared_ptr.hpp>
 
+#include "regex_engine.h"
+#include "filter_stats.h"
+
 namespace swd {
     /**
      * @brief Models a blacklist filter.
@@ -78,6 +81,13 @@ namespace swd {
              */
             void set_regex(const std::string& regex);
 
+            /**
+             * @brief Get the regular expression of the filter.
+             *
+             * @return The regular expression of the filter
+             */
+            const std::string& get_regex() const;
+
             /**
              * @brief Test for input if the regular expression matches.
              *
@@ -86,6 +96,73 @@ namespace swd {
              */
             bool matches(const std::string& input) const;
 
+            /**
+             * @brief Test for input if the regular expression matches, using
+             *  the folded input if the filter was folded.
+             *
+             * @param input The string that should be tested
+             * @param folded The same string folded to lowercase
+             * @return The result of the test
+             */
+            bool matches(const std::string& input, const std::string& folded) const;
+
+            /**
+             * @brief Test for input if the regular expression matches, scanning
+             *  long input in overlapping windows.
+             *
+             * Consecutive windows overlap by the maximum match span of the
+             * filter, so no match is lost at a window border and the scan
+             * time grows linearly with the length of the input. Filters
+             * without a bounded span test the input as a whole, unless an
+             * assumed span is set for them. Their matches that are longer
+             * than that span are missed if they cross a window border.
+             *
+             * @param input The string that should be tested
+             * @param folded The same string folded to lowercase
+             * @param window The size of a window or zero to test the input as a whole
+             * @param unbounded_span The assumed span of filters without a bound
+             *  or zero to test the input as a whole
+             * @return The result of the test
+             */
+            bool matches(const std::string& input, const std::string& folded,
+             std::size_t window, std::size_t unbounded_span = 0) const;
+
+            /**
+             * @brief Get the maximum number of characters a match can span.
+             *
+             * @return The maximum span or swd::match_span::UNBOUNDED
+             */
+            long get_max_span() const;
+
+            /**
+             * @brief Check if every match of the filter contains a character
+             *  that is not a safe character.
+             *
+             * @return True if strings of safe characters can not match
+             */
+            bool needs_special() const;
+
+            /**
+             * @brief Add a tag to the filter.
+             *
+             * @param tag_id The id of the tag
+             */
+            void add_tag(const unsigned long long& tag_id);
+
+            /**
+             * @brief Get the tags of the filter.
+             *
+             * @return The ids of the tags
+             */
+            const std::set<unsigned long long>& get_tags() const;
+
+            /**
+             * @brief Get the evaluation statistics of the filter.
+             *
+             * @return The statistics of the filter
+             */
+            swd::filter_stats& get_stats();
+
         private:
             /**
              * @brief The database id of the filter.
@@ -100,7 +177,37 @@ namespace swd {
             /**
              * @brief The regular expression of the filter.
              */
-            boost::regex regex_;
+            std::string regex_;
+
+            /**
+             * @brief The compiled regular expression of the filter.
+             */
+            swd::regex_engine_ptr engine_;
+
+            /**
+             * @brief True if the regular expression is folded and case-sensitive.
+             */
+            bool folded_ = false;
+
+            /**
+             * @brief False if the filter might match safe characters only.
+             */
+            bool needs_special_ = false;
+
+            /**
+             * @brief The maximum span of a match of the regular expression.
+             */
+            long max_span_ = -1;
+
+            /**
+             * @brief The ids of the tags of the filter.
+             */
+            std::set<unsigned long long> tags_;
+
+            /**
+             * @brief The evaluation statistics of the filter.
+             */
+            swd::filter_stats stats_;
     };
 
     /**
@@ -0,0 +1,131 @@
+/**
+ * Shadow Daemon -- Web Application Firewall
+ *
+ *   Copyright (C) 2014-2022 Hendrik Buchwald <hb@zecure.org>
+ *
+ * This file is part of Shadow Daemon. Shadow Daemon is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, version 2.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#ifndef BLACKLIST_FILTER_SET_H
+#define BLACKLIST_FILTER_SET_H
+
+#include <atomic>
+#include <vector>
+#include <boost/shared_ptr.hpp>
+
+#include "blacklist_filter.h"
+
+namespace swd {
+    /**
+     * @brief Indexes of the filters of a set in the order of evaluation.
+     */
+    using filter_order_ptr = boost::shared_ptr<const std::vector<unsigned int>>;
+
+    /**
+     * @brief Models an immutable set of blacklist filters.
+     *
+     * Every set gets a unique generation when it is created. Results that were
+     * computed with the filters of a set can be stored together with the
+     * generation and are outdated as soon as the filters are replaced.
+     */
+    class blacklist_filter_set {
+        public:
+            /**
+             * @brief Construct a filter set with a new generation.
+             *
+             * @param filters The blacklist filters of the set
+             */
+            blacklist_filter_set(swd::blacklist_filters filters);
+
+            /**
+             * @brief Get the filters of the set.
+             *
+             * @return The list of blacklist filters
+             */
+            const swd::blacklist_filters& get_filters() const;
+
+            /**
+             * @brief Get the generation of the set.
+             *
+             * @return The unique generation of the set
+             */
+            unsigned long long get_generation() const;
+
+            /**
+             * @brief Get the filters that might match strings of safe
+             *  characters.
+             *
+             * @return The indexes of the filters in the set
+             */
+            const std::vector<unsigned int>& get_safe_filters() const;
+
+            /**
+             * @brief Get the filters sorted by their impact per cost, highest
+             *  first.
+             *
+             * The order is shared by all requests. It is sorted again from a
+             * snapshot of the statistics at most once per second, by the first
+             * request that notices that it is outdated.
+             *
+             * @return The indexes of the filters in the order of evaluation
+             */
+            swd::filter_order_ptr get_order() const;
+
+        private:
+            /**
+             * @brief The blacklist filters of the set.
+             */
+            swd::blacklist_filters filters_;
+
+            /**
+             * @brief The unique generation of the set.
+             */
+            unsigned long long generation_;
+
+            /**
+             * @brief The indexes of the filters that do not need special
+             *  characters.
+             */
+            std::vector<unsigned int> safe_filters_;
+
+            /**
+             * @brief The cached order of evaluation.
+             */
+            mutable swd::filter_order_ptr order_;
+
+            /**
+             * @brief The steady clock time of the last sort in nanoseconds.
+             */
+            mutable std::atomic<long long> order_time_;
+    };
+
+    /**
+     * @brief Blacklist filter set pointer.
+     */
+    using blacklist_filter_set_ptr = boost::shared_ptr<const swd::blacklist_filter_set>;
+}
+
+#endif /* BLACKLIST_FILTER_SET_H */
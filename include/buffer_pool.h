@@ -0,0 +1,115 @@
+/**
+ * Shadow Daemon -- Web Application Firewall
+ *
+ *   Copyright (C) 2014-2022 Hendrik Buchwald <hb@zecure.org>
+ *
+ * This file is part of Shadow Daemon. Shadow Daemon is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, version 2.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#ifndef BUFFER_POOL_H
+#define BUFFER_POOL_H
+
+#include <vector>
+#include <boost/array.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+namespace swd {
+    /**
+     * @brief Buffer for incoming data.
+     */
+    using buffer = boost::array<char, 8192>;
+
+    /**
+     * @brief Buffer pointer.
+     */
+    using buffer_ptr = boost::shared_ptr<swd::buffer>;
+
+    /**
+     * @brief Shares read buffers between all connections.
+     *
+     * A connection only needs a buffer while data is being read from its
+     * socket. Instead of embedding one in every connection object the buffers
+     * are borrowed from this pool and handed back after the data is parsed,
+     * so idle connections do not pin any buffer memory.
+     */
+    class buffer_pool :
+     private boost::noncopyable {
+        public:
+            /**
+             * @brief Construct the buffer pool.
+             *
+             * @param max_idle The maximum number of unused buffers that are
+             *  kept for reuse, additional buffers are freed on release
+             */
+            buffer_pool(std::size_t max_idle = 256);
+
+            /**
+             * @brief Borrow a buffer from the pool.
+             *
+             * @return A reused buffer or a new one if the pool is empty
+             */
+            swd::buffer_ptr acquire();
+
+            /**
+             * @brief Hand a buffer back to the pool.
+             *
+             * @param buffer The pointer to the borrowed buffer
+             */
+            void release(const swd::buffer_ptr& buffer);
+
+            /**
+             * @brief Get the number of unused buffers in the pool.
+             *
+             * @return The number of idle buffers
+             */
+            std::size_t get_idle() const;
+
+        private:
+            /**
+             * @brief The maximum number of idle buffers.
+             */
+            std::size_t max_idle_;
+
+            /**
+             * @brief The unused buffers.
+             */
+            std::vector<swd::buffer_ptr> buffers_;
+
+            /**
+             * @brief The mutex for the unused buffers.
+             */
+            mutable boost::mutex mutex_;
+    };
+
+    /**
+     * @brief Buffer pool pointer.
+     */
+    using buffer_pool_ptr = boost::shared_ptr<swd::buffer_pool>;
+}
+
+#endif /* BUFFER_POOL_H */
@@ -32,7 +32,9 @@
 #ifndef CACHE_H
 #define CACHE_H
 
+#include <atomic>
 #include <map>
+#include <set>
 #include <boost/thread.hpp>
 #include <boost/thread/mutex.hpp>
 #include <boost/shared_ptr.hpp>
@@ -40,6 +42,11 @@
 #include "cached.h"
 #include "database.h"
 #include "blacklist_rule.h"
+#include "blacklist_filter_set.h"
+#include "scan_memo.h"
+#include "filter_quarantine.h"
+#include "scan_batcher.h"
+#include "hmac.h"
 
 namespace swd {
     /**
@@ -130,6 +137,50 @@ namespace swd {
              */
             swd::blacklist_filters get_blacklist_filters();
 
+            /**
+             * @brief Get all blacklist filters as a set with a generation.
+             *
+             * The set is replaced whenever the filters are loaded again.
+             *
+             * @return The current blacklist filter set
+             */
+            swd::blacklist_filter_set_ptr get_blacklist_filter_set();
+
+            /**
+             * @brief Get the blacklist filters that are enabled for a profile.
+             *
+             * Filters with at least one disabled tag are left out. Profiles
+             * that disable the same tags share one set, so that its scan
+             * results are remembered only once.
+             *
+             * @param disabled_tags The ids of the tags that are disabled
+             * @return The blacklist filter set without the disabled filters
+             */
+            swd::blacklist_filter_set_ptr get_blacklist_filter_set(
+             const std::set<unsigned long long>& disabled_tags);
+
+            /**
+             * @brief Get the memo table for the results of the blacklist filters.
+             *
+             * @return The pointer to the scan memo
+             */
+            swd::scan_memo_ptr get_scan_memo();
+
+            /**
+             * @brief Get the quarantine policy for slow blacklist filters.
+             *
+             * @return The pointer to the filter quarantine
+             */
+            swd::filter_quarantine_ptr get_filter_quarantine();
+
+            /**
+             * @brief Get the batcher that scans the strings of concurrent
+             *  requests together.
+             *
+             * @return The pointer to the scan batcher
+             */
+            swd::scan_batcher_ptr get_scan_batcher();
+
             /**
              * @brief Add whitelist rules to the cache. Unit tests only.
              *
@@ -196,6 +247,47 @@ namespace swd {
             swd::integrity_rules get_integrity_rules(const unsigned long long& profile_id,
              const std::string& caller);
 
+            /**
+             * @brief Get a keyed hmac for a profile.
+             *
+             * The key schedule is computed only once per profile. Callers copy
+             * the returned object and feed the content into the copy. If the
+             * key of the profile changed the hmac is computed again.
+             *
+             * @param profile_id The id of the profile
+             * @param key The hmac key of the profile
+             * @return The keyed hmac that must not be modified
+             */
+            swd::hmac_ptr get_hmac(const unsigned long long& profile_id,
+             const std::string& key);
+
+            /**
+             * @brief Look up a keyed hmac without touching the database.
+             *
+             * This is used to start hashing the content before the profile is
+             * fetched, so the key has to be compared with the profile later.
+             *
+             * @param profile_id The id of the profile
+             * @return The key and the keyed hmac or a null pointer if unknown
+             */
+            std::pair<std::string, swd::hmac_ptr> find_hmac(
+             const unsigned long long& profile_id);
+
+            /**
+             * @brief Check if a profile with the id exists.
+             *
+             * The ids of all profiles are kept in memory, so that requests for
+             * unknown profiles can be rejected without a query. An unknown id
+             * reloads the ids, but at most once per second and only by one
+             * thread at a time, so that random ids can not flood the database.
+             * The ids are replaced as a whole, so readers never wait for the
+             * database.
+             *
+             * @param profile_id The id of the profile
+             * @return True if the profile exists
+             */
+            bool has_profile_id(const unsigned long long& profile_id);
+
         private:
             /**
              * @brief Loop over the cached objects and remove outdated elements.
@@ -208,9 +300,31 @@ namespace swd {
             swd::database_ptr database_;
 
             /**
-             * @brief The cache vector for blacklist filters.
+             * @brief The cache for the set of blacklist filters.
+             */
+            swd::blacklist_filter_set_ptr blacklist_filter_set_;
+
+            /**
+             * @brief The cache for the subsets of the blacklist filters per
+             *  combination of disabled tags.
+             */
+            std::map<std::set<unsigned long long>, swd::blacklist_filter_set_ptr>
+             blacklist_filter_subsets_;
+
+            /**
+             * @brief The memo table for the results of the blacklist filters.
+             */
+            swd::scan_memo_ptr scan_memo_;
+
+            /**
+             * @brief The quarantine policy for slow blacklist filters.
+             */
+            swd::filter_quarantine_ptr filter_quarantine_;
+
+            /**
+             * @brief The batcher that scans the strings of concurrent requests together.
              */
-            swd::blacklist_filters blacklist_filters_;
+            swd::scan_batcher_ptr scan_batcher_;
 
             /**
              * @brief The cache map for blacklist rules.
@@ -230,6 +344,23 @@ namespace swd {
             std::map< unsigned long long, std::map<std::string,
              swd::cached_integrity_rules_ptr> > integrity_rules_;
 
+            /**
+             * @brief The cache map for the keyed hmacs and their keys.
+             */
+            std::map< unsigned long long, std::pair<std::string,
+             swd::hmac_ptr> > hmacs_;
+
+            /**
+             * @brief The snapshot of the ids of all profiles.
+             */
+            boost::shared_ptr<const std::set<unsigned long long>> profile_ids_;
+
+            /**
+             * @brief The steady clock time of the last reload of the profile
+             *  ids in nanoseconds.
+             */
+            std::atomic<long long> profile_ids_loaded_{0};
+
             /**
              * @brief The mutex for the blacklist filters.
              */
@@ -250,6 +381,11 @@ namespace swd {
              */
             boost::mutex integrity_rules_mutex_;
 
+            /**
+             * @brief The mutex for the keyed hmacs.
+             */
+            boost::mutex hmacs_mutex_;
+
             /**
              * @brief Switch to exit cleanup loop.
              */
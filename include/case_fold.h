@@ -0,0 +1,88 @@
+/**
+ * Shadow Daemon -- Web Application Firewall
+ *
+ *   Copyright (C) 2014-2022 Hendrik Buchwald <hb@zecure.org>
+ *
+ * This file is part of Shadow Daemon. Shadow Daemon is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, version 2.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#ifndef CASE_FOLD_H
+#define CASE_FOLD_H
+
+#include <string>
+
+namespace swd {
+    /**
+     * @brief Folds strings and regular expressions to lowercase.
+     *
+     * Case-insensitive regular expressions have to compare both cases of every
+     * character. It is a lot cheaper to fold every value once and to match it
+     * with a case-sensitive regular expression that only contains lowercase
+     * letters. Only ASCII letters are folded, just like boost does it with the
+     * default locale.
+     */
+    class case_fold {
+        public:
+            /**
+             * @brief Fold a string to lowercase.
+             *
+             * The loop is branch free, so the compiler is able to vectorize it.
+             *
+             * @param input The string that gets folded
+             * @param output The buffer for the folded string
+             */
+            static void fold(const std::string& input, std::string& output);
+
+            /**
+             * @brief Fold the literal letters of a regular expression.
+             *
+             * The folded expression matches folded strings exactly like the
+             * original expression matches strings case-insensitively. Escapes
+             * and classes whose meaning would change, like hex escapes or
+             * ranges across cases, are not folded.
+             *
+             * @param regex The regular expression in perl syntax
+             * @param output The folded regular expression
+             * @return False if the regular expression can not be folded
+             */
+            static bool fold_regex(const std::string& regex, std::string& output);
+
+        private:
+            /**
+             * @brief Copy an escape sequence if its meaning does not depend on
+             *  the case.
+             *
+             * @param regex The regular expression
+             * @param pos The position after the backslash
+             * @param output The folded regular expression
+             * @return False if the escape can not be folded
+             */
+            static bool copy_escape(const std::string& regex, std::size_t& pos,
+             std::string& output);
+    };
+}
+
+#endif /* CASE_FOLD_H */
@@ -32,10 +32,10 @@
 #ifndef CONNECTION_H
 #define CONNECTION_H
 
+#include <memory>
 #include <boost/asio.hpp>
 #include <boost/asio/ssl.hpp>
 #include <boost/bind.hpp>
-#include <boost/array.hpp>
 #include <boost/enable_shared_from_this.hpp>
 #include <boost/make_shared.hpp>
 #include <boost/noncopyable.hpp>
@@ -46,6 +46,10 @@
 #include "storage.h"
 #include "cache.h"
 #include "request_parser.h"
+#include "buffer_pool.h"
+#include "admission.h"
+#include "analysis_pool.h"
+#include "scan_pool.h"
 
 namespace swd {
     /**
@@ -70,6 +74,14 @@ namespace swd {
 
     /**
      * @brief Represents a connection from a client.
+     *
+     * Connections are kept small so that a large number of idle keep-alive
+     * connections stays cheap. Only the transport that is actually used gets
+     * allocated and the read buffer is borrowed from a shared pool. The object
+     * itself has to stay below 512 bytes (432 bytes on x86-64), so an idle
+     * plain connection including its request, reply and socket costs roughly
+     * 1.1 KiB of user space memory. Ssl connections additionally pay for the
+     * OpenSSL state and keep their buffer while a read is pending.
      */
     class connection :
      public boost::enable_shared_from_this<swd::connection>,
@@ -85,24 +97,30 @@ namespace swd {
              * @param storage The pointer to the storage object
              * @param database The pointer to the database object
              * @param cache The pointer to the cache object
+             * @param buffer_pool The pointer to the shared buffer pool
+             * @param admission The pointer to the admission control
+             * @param analysis_pool The pointer to the analysis pool
+             * @param scan_pool The pointer to the pool that splits large requests
              */
             explicit connection(boost::asio::io_service& io_service,
              swd::context& context, bool ssl, swd::storage_ptr storage,
-             swd::database_ptr database, swd::cache_ptr cache);
+             swd::database_ptr database, swd::cache_ptr cache,
+             swd::buffer_pool_ptr buffer_pool, swd::admission_ptr admission,
+             swd::analysis_pool_ptr analysis_pool, swd::scan_pool_ptr scan_pool);
 
             /**
-             * @brief Get the socket associated with the connection.
-             *
-             * @return The socket
+             * @brief Unregister the connection from the admission control.
              */
-            swd::socket& socket();
+            ~connection();
 
             /**
-             * @brief Get the ssl socket associated with the connection.
+             * @brief Get the tcp socket associated with the connection.
              *
-             * @return The ssl socket
+             * If ssl is enabled this is the lowest layer of the ssl stream.
+             *
+             * @return The socket
              */
-            swd::ssl_socket::lowest_layer_type& ssl_socket();
+            swd::socket& socket();
 
             /**
              * @brief Start the asynchronous operation for the connection.
@@ -122,6 +140,40 @@ namespace swd {
              */
             void start_read(const boost::system::error_code& e);
 
+            /**
+             * @brief Handle readability of the socket and borrow a buffer to
+             *  read the available data.
+             *
+             * @param e The error code of the wait operation
+             */
+            void handle_wait(const boost::system::error_code& e);
+
+            /**
+             * @brief Arm the deadline timer.
+             *
+             * The deadline is the earlier one of the given timeout and the
+             * deadline for the complete request. Timeouts smaller than one
+             * disable the respective limit.
+             *
+             * @param timeout The timeout in seconds
+             */
+            void set_deadline(int timeout);
+
+            /**
+             * @brief Cancel the deadline timer.
+             */
+            void cancel_deadline();
+
+            /**
+             * @brief Handle expiration of the deadline timer.
+             *
+             * Closes the socket, so that all pending operations are aborted
+             * and the connection gets destroyed.
+             *
+             * @param e The error code of the wait operation
+             */
+            void handle_deadline(const boost::system::error_code& e);
+
             /**
              * @brief Handle completion of a read operation.
              *
@@ -131,6 +183,46 @@ namespace swd {
             void handle_read(const boost::system::error_code& e,
              std::size_t bytes_transferred);
 
+            /**
+             * @brief Analyze a complete request on a thread of the analysis
+             *  pool and hand the reply back to the strand.
+             *
+             * @param valid False if the request could not be parsed
+             */
+            void handle_analysis(bool valid);
+
+            /**
+             * @brief Check and analyze a complete request and encode the reply.
+             *
+             * @param valid False if the request could not be parsed
+             */
+            void process(bool valid);
+
+            /**
+             * @brief Check and analyze a complete request and set the status
+             *  of the reply.
+             *
+             * @param valid False if the request could not be parsed
+             */
+            void analyze(bool valid);
+
+            /**
+             * @brief Log a rejected request and set the status of the reply.
+             *
+             * In passive mode and for requests that are shed in fail-open mode
+             * the reply is still a success.
+             *
+             * @param code The status code of the rejection
+             * @param message The reason of the rejection
+             * @param report False if the rejection should not be logged
+             */
+            void reject(int code, const std::string& message, bool report = true);
+
+            /**
+             * @brief Start sending the reply to the client.
+             */
+            void start_write();
+
             /**
              * @brief Handle completion of a write operation.
              *
@@ -144,19 +236,71 @@ namespace swd {
             boost::asio::io_service::strand strand_;
 
             /**
-             * @brief Socket for a connection.
+             * @brief Timer that limits the handshake, idle time and total
+             *  time of a request.
              */
-            swd::socket socket_;
+            boost::asio::steady_timer timer_;
 
             /**
-             * @brief Socket for a ssl connection.
+             * @brief Point in time at which the complete request has to be read.
              */
-            swd::ssl_socket ssl_socket_;
+            boost::asio::steady_timer::time_point request_deadline_;
 
             /**
-             * @brief Buffer for incoming data.
+             * @brief Seconds a ssl client has to finish the handshake.
              */
-            boost::array<char, 8192> buffer_;
+            int timeout_handshake_ = -1;
+
+            /**
+             * @brief Seconds a client may stay silent while being expected to send
+             *  or receive data.
+             */
+            int timeout_idle_ = -1;
+
+            /**
+             * @brief Seconds a client has to send the complete request.
+             */
+            int timeout_request_ = -1;
+
+            /**
+             * @brief The status of the registration at the admission control.
+             */
+            bool registered_ = false;
+
+            /**
+             * @brief True if the request is answered without analysis.
+             */
+            bool shed_ = false;
+
+            /**
+             * @brief True if shed requests are answered with STATUS_OK.
+             */
+            bool fail_open_ = false;
+
+            /**
+             * @brief True if the cache was already asked for the key of the profile.
+             */
+            bool hmac_checked_ = false;
+
+            /**
+             * @brief The reserved analysis slot while the request is analyzed.
+             */
+            std::unique_ptr<swd::analysis_slot> analysis_slot_;
+
+            /**
+             * @brief Socket for a connection. Only allocated without ssl.
+             */
+            std::unique_ptr<swd::socket> socket_;
+
+            /**
+             * @brief Socket for a ssl connection. Only allocated with ssl.
+             */
+            std::unique_ptr<swd::ssl_socket> ssl_socket_;
+
+            /**
+             * @brief Buffer for incoming data. Only set while reading.
+             */
+            swd::buffer_ptr buffer_;
 
             /**
              * @brief IP address of shadowd client/httpd server.
@@ -200,6 +344,26 @@ namespace swd {
              * @brief The pointer to the cache object.
              */
             swd::cache_ptr cache_;
+
+            /**
+             * @brief The pointer to the shared buffer pool.
+             */
+            swd::buffer_pool_ptr buffer_pool_;
+
+            /**
+             * @brief The pointer to the admission control.
+             */
+            swd::admission_ptr admission_;
+
+            /**
+             * @brief The pointer to the analysis pool.
+             */
+            swd::analysis_pool_ptr analysis_pool_;
+
+            /**
+             * @brief The pointer to the pool that splits large requests.
+             */
+            swd::scan_pool_ptr scan_pool_;
     };
 
     /**
@@ -33,6 +33,7 @@
 #define DATABASE_H
 
 #include <string>
+#include <vector>
 #include <boost/thread/mutex.hpp>
 #include <boost/shared_ptr.hpp>
 #include <dbi/dbi.h>
@@ -120,12 +121,19 @@ namespace swd {
              const std::string& caller, const std::string& path);
 
             /**
-             * @brief Get all blacklist filters.
+             * @brief Get all blacklist filters together with their tags.
              *
              * @return The corresponding table rows
              */
             swd::blacklist_filters get_blacklist_filters();
 
+            /**
+             * @brief Get the ids of all profiles.
+             *
+             * @return The ids of the profiles
+             */
+            std::vector<unsigned long long> get_profile_ids();
+
             /**
              * @brief Get whitelist rules.
              *
@@ -0,0 +1,98 @@
+/**
+ * Shadow Daemon -- Web Application Firewall
+ *
+ *   Copyright (C) 2014-2022 Hendrik Buchwald <hb@zecure.org>
+ *
+ * This file is part of Shadow Daemon. Shadow Daemon is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, version 2.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#ifndef FILTER_QUARANTINE_H
+#define FILTER_QUARANTINE_H
+
+#include <atomic>
+#include <boost/shared_ptr.hpp>
+
+#include "filter_stats.h"
+
+namespace swd {
+    /**
+     * @brief Moves blacklist filters that exceed a cost budget to a sampled path.
+     *
+     * A single slow filter can use more time than all other filters together.
+     * If the average duration of its evaluations exceeds the budget the filter
+     * is quarantined and only evaluated for every n-th input, so that it still
+     * shows up in the logs. The quarantine ends when the filters are reloaded.
+     */
+    class filter_quarantine {
+        public:
+            /**
+             * @brief Change the cost budget.
+             *
+             * @param nanoseconds The max average duration of an evaluation or
+             *  -1 to disable the quarantine
+             * @param sample_rate Quarantined filters are evaluated for every
+             *  n-th input
+             */
+            void set_budget(int nanoseconds, int sample_rate);
+
+            /**
+             * @brief Check if an evaluation of a filter should be skipped.
+             *
+             * @param stats The statistics of the filter
+             * @return True if the filter is quarantined and this input is not sampled
+             */
+            bool skip(swd::filter_stats& stats) const;
+
+            /**
+             * @brief Quarantine a filter if it exceeds the cost budget.
+             *
+             * Filters are only judged after a minimum number of evaluations,
+             * so that a few slow inputs do not quarantine a filter.
+             *
+             * @param id The id of the filter for the alert
+             * @param stats The statistics of the filter
+             */
+            void check(unsigned long long id, swd::filter_stats& stats) const;
+
+        private:
+            /**
+             * @brief The max average duration of an evaluation or -1.
+             */
+            std::atomic<int> budget_{-1};
+
+            /**
+             * @brief The sampling rate of quarantined filters.
+             */
+            std::atomic<int> sample_rate_{100};
+    };
+
+    /**
+     * @brief Filter quarantine pointer.
+     */
+    using filter_quarantine_ptr = boost::shared_ptr<swd::filter_quarantine>;
+}
+
+#endif /* FILTER_QUARANTINE_H */
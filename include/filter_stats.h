@@ -0,0 +1,158 @@
+/**
+ * Shadow Daemon -- Web Application Firewall
+ *
+ *   Copyright (C) 2014-2022 Hendrik Buchwald <hb@zecure.org>
+ *
+ * This file is part of Shadow Daemon. Shadow Daemon is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, version 2.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#ifndef FILTER_STATS_H
+#define FILTER_STATS_H
+
+#include <atomic>
+
+namespace swd {
+    /**
+     * @brief Counts how often a filter is evaluated and how much time it costs.
+     *
+     * The counters are updated by all analysis threads at once, so they are
+     * atomic. The order of the updates does not matter, only the sums.
+     */
+    class filter_stats {
+        public:
+            /**
+             * @brief Count an evaluation of the filter.
+             *
+             * @param nanoseconds The duration of the evaluation
+             * @param match True if the filter matched
+             */
+            void add_evaluation(unsigned long long nanoseconds, bool match);
+
+            /**
+             * @brief Count an evaluation that the regex engine aborted, e.g.
+             *  because of catastrophic backtracking.
+             *
+             * @param nanoseconds The duration of the evaluation
+             */
+            void add_abort(unsigned long long nanoseconds);
+
+            /**
+             * @brief Count an input that reached the filter in quarantine.
+             *
+             * @return The number of inputs in quarantine before this one
+             */
+            unsigned long long add_quarantined_input();
+
+            /**
+             * @brief Mark the filter as quarantined.
+             *
+             * @return True if the filter was not quarantined before
+             */
+            bool quarantine();
+
+            /**
+             * @brief Check if the filter is quarantined.
+             *
+             * @return The quarantine status of the filter
+             */
+            bool is_quarantined() const;
+
+            /**
+             * @brief Get the number of evaluations, including aborted ones.
+             *
+             * @return The number of evaluations
+             */
+            unsigned long long get_evaluations() const;
+
+            /**
+             * @brief Get the number of matches.
+             *
+             * @return The number of matches
+             */
+            unsigned long long get_matches() const;
+
+            /**
+             * @brief Get the number of aborted evaluations.
+             *
+             * @return The number of aborted evaluations
+             */
+            unsigned long long get_aborts() const;
+
+            /**
+             * @brief Get the number of inputs that reached the filter in quarantine.
+             *
+             * @return The number of inputs in quarantine, sampled or not
+             */
+            unsigned long long get_quarantined_inputs() const;
+
+            /**
+             * @brief Get the total duration of all evaluations.
+             *
+             * @return The cumulative nanoseconds
+             */
+            unsigned long long get_nanoseconds() const;
+
+            /**
+             * @brief Get the average duration of an evaluation.
+             *
+             * @return The average nanoseconds or 0 if there are no evaluations
+             */
+            unsigned long long get_average_nanoseconds() const;
+
+        private:
+            /**
+             * @brief The number of evaluations.
+             */
+            std::atomic<unsigned long long> evaluations_{0};
+
+            /**
+             * @brief The number of matches.
+             */
+            std::atomic<unsigned long long> matches_{0};
+
+            /**
+             * @brief The number of aborted evaluations.
+             */
+            std::atomic<unsigned long long> aborts_{0};
+
+            /**
+             * @brief The number of inputs in quarantine.
+             */
+            std::atomic<unsigned long long> quarantined_inputs_{0};
+
+            /**
+             * @brief The total duration of all evaluations.
+             */
+            std::atomic<unsigned long long> nanoseconds_{0};
+
+            /**
+             * @brief True if the filter exceeded the cost budget.
+             */
+            std::atomic<bool> quarantined_{false};
+    };
+}
+
+#endif /* FILTER_STATS_H */
@@ -54,7 +54,7 @@ namespace swd {
              *
              * @return The algorithm of the hash
              */
-            std::string get_algorithm() const;
+            const std::string& get_algorithm() const;
 
             /**
              * @brief Set the digest of the hash.
@@ -68,7 +68,7 @@ namespace swd {
              *
              * @return The digest of the hash
              */
-            std::string get_digest() const;
+            const std::string& get_digest() const;
 
         private:
             /**
@@ -29,17 +29,23 @@
  * files in the program, then also delete it here.
  */
 
-#include "connection_exception.h"
+#ifndef HMAC_H
+#define HMAC_H
 
-swd::exceptions::connection_exception::connection_exception(int code, std::string message) :
- code_(code),
- message_(std::move(message)) {
-}
+#include <cryptopp/hmac.h>
+#include <cryptopp/sha.h>
+#include <boost/shared_ptr.hpp>
 
-int swd::exceptions::connection_exception::get_code() const {
-    return code_;
-}
+namespace swd {
+    /**
+     * @brief The hmac that is used for the signatures of requests.
+     */
+    using hmac = CryptoPP::HMAC<CryptoPP::SHA256>;
 
-std::string swd::exceptions::connection_exception::get_message() const {
-    return message_;
+    /**
+     * @brief Pointer to a keyed hmac that is copied for every request.
+     */
+    using hmac_ptr = boost::shared_ptr<const swd::hmac>;
 }
+
+#endif /* HMAC_H */
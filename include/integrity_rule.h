@@ -70,7 +70,7 @@ namespace swd {
              *
              * @return The hash algorithm of the rule
              */
-            std::string get_algorithm() const;
+            const std::string& get_algorithm() const;
 
             /**
              * @brief Set the hash digest of the rule
@@ -84,7 +84,7 @@ namespace swd {
              *
              * @return The hash digest of the rule
              */
-            std::string get_digest() const;
+            const std::string& get_digest() const;
 
             /**
              * @brief Checks if the hash matches the rule.
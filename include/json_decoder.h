@@ -0,0 +1,227 @@
+/**
+ * Shadow Daemon -- Web Application Firewall
+ *
+ *   Copyright (C) 2014-2022 Hendrik Buchwald <hb@zecure.org>
+ *
+ * This file is part of Shadow Daemon. Shadow Daemon is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, version 2.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#ifndef JSON_DECODER_H
+#define JSON_DECODER_H
+
+#include <string>
+#include <vector>
+
+#include "request.h"
+
+namespace swd {
+    /**
+     * @brief Decodes the json content of a request in a single pass.
+     *
+     * Instead of building a complete document tree first, the decoder reads
+     * the content once and moves the values straight into the request. The
+     * security limits are checked while decoding, so abusive requests are
+     * rejected as soon as a limit is exceeded.
+     */
+    class json_decoder {
+        public:
+            /**
+             * @brief Construct a decoder for a request.
+             *
+             * @param request The pointer to the request object that receives the values
+             * @param max_parameters The max number of parameters or -1
+             * @param max_length_path The max length of parameter paths or -1
+             * @param max_length_value The max length of parameter values or -1
+             */
+            json_decoder(swd::request_ptr request, int max_parameters = -1,
+             int max_length_path = -1, int max_length_value = -1);
+
+            /**
+             * @brief Decode the content.
+             *
+             * @param content The encoded json content of the request
+             * @return STATUS_OK on success, STATUS_BAD_JSON if the content is
+             *  invalid and STATUS_BAD_REQUEST if a limit is exceeded
+             */
+            int decode(const std::string& content);
+
+            /**
+             * @brief Get the reason of a failed decoding.
+             *
+             * @return The error message
+             */
+            const std::string& get_message() const;
+
+            /**
+             * @brief Get the keys of input values and hashes that were skipped.
+             *
+             * Objects and arrays can not be converted to text, so they are not
+             * added to the request.
+             *
+             * @return The keys of the skipped values
+             */
+            const std::vector<std::string>& get_skipped() const;
+
+        private:
+            /**
+             * @brief Parse the root object and move the values into the request.
+             *
+             * @param client_ip Set to true if a client ip is defined
+             * @param input Set to true if the input is defined
+             * @param hashes Set to true if the hashes are defined
+             * @return False if the content is invalid or a limit is exceeded
+             */
+            bool parse_root(bool& client_ip, bool& input, bool& hashes);
+
+            /**
+             * @brief Parse a value of the root object that is a string or scalar.
+             *
+             * Null is accepted and reported with defined set to false.
+             *
+             * @param output The decoded value
+             * @param defined False if the value is null
+             * @return False if the value is invalid
+             */
+            bool parse_text(std::string& output, bool& defined);
+
+            /**
+             * @brief Parse the input or hashes and add them to the request.
+             *
+             * @param hashes True for hashes, false for parameters
+             * @param defined False if the value is null
+             * @return False if the value is invalid or a limit is exceeded
+             */
+            bool parse_pairs(bool hashes, bool& defined);
+
+            /**
+             * @brief Parse a string and decode the escape sequences.
+             *
+             * @param output The decoded string
+             * @param max_length The max length of the decoded string or -1
+             * @param limit_message The reason if the string is too long
+             * @return False if the string is invalid or too long
+             */
+            bool parse_string(std::string& output, int max_length = -1,
+             const char* limit_message = nullptr);
+
+            /**
+             * @brief Parse the four hex digits of an unicode escape sequence.
+             *
+             * @param code_point The parsed code unit
+             * @return False if the digits are invalid
+             */
+            bool parse_hex(unsigned int& code_point);
+
+            /**
+             * @brief Parse a number and keep its textual representation.
+             *
+             * @param output The number as string
+             * @return False if the number is invalid
+             */
+            bool parse_number(std::string& output);
+
+            /**
+             * @brief Skip a value that is not used.
+             *
+             * @param depth The current nesting depth
+             * @return False if the value is invalid
+             */
+            bool skip_value(int depth = 0);
+
+            /**
+             * @brief Consume a literal like true, false or null.
+             *
+             * @param literal The expected literal
+             * @return False if the input does not match
+             */
+            bool consume(const char* literal);
+
+            /**
+             * @brief Skip whitespace characters.
+             */
+            void skip_whitespace();
+
+            /**
+             * @brief Mark the decoding as failed because of a limit.
+             *
+             * @param message The reason
+             * @return Always false
+             */
+            bool exceed(const std::string& message);
+
+            /**
+             * @brief The pointer to the request object.
+             */
+            swd::request_ptr request_;
+
+            /**
+             * @brief The max number of parameters.
+             */
+            int max_parameters_;
+
+            /**
+             * @brief The max length of parameter paths.
+             */
+            int max_length_path_;
+
+            /**
+             * @brief The max length of parameter values.
+             */
+            int max_length_value_;
+
+            /**
+             * @brief The number of decoded parameters.
+             */
+            int parameters_ = 0;
+
+            /**
+             * @brief The current position in the content.
+             */
+            const char* pos_ = nullptr;
+
+            /**
+             * @brief The end of the content.
+             */
+            const char* end_ = nullptr;
+
+            /**
+             * @brief True if a limit was exceeded.
+             */
+            bool exceeded_ = false;
+
+            /**
+             * @brief The reason of a failed decoding.
+             */
+            std::string message_;
+
+            /**
+             * @brief The keys of the skipped values.
+             */
+            std::vector<std::string> skipped_;
+    };
+}
+
+#endif /* JSON_DECODER_H */
@@ -0,0 +1,164 @@
+/**
+ * Shadow Daemon -- Web Application Firewall
+ *
+ *   Copyright (C) 2014-2022 Hendrik Buchwald <hb@zecure.org>
+ *
+ * This file is part of Shadow Daemon. Shadow Daemon is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, version 2.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#ifndef MATCH_SPAN_H
+#define MATCH_SPAN_H
+
+#include <string>
+
+namespace swd {
+    /**
+     * @brief Determines the maximum length of a match of a regular expression.
+     *
+     * Long values are scanned in overlapping windows. A window only has to
+     * overlap its successor by the longest possible match, so that no match
+     * is lost at the border between two windows.
+     */
+    class match_span {
+        public:
+            /**
+             * @brief The length of expressions without a known upper bound.
+             */
+            static const long UNBOUNDED = -1;
+
+            /**
+             * @brief Lengths above this limit are treated as unbounded.
+             */
+            static const long MAX_LENGTH = 1048576;
+
+            /**
+             * @brief Get the maximum number of characters a regular
+             *  expression can match, including the characters that are
+             *  examined by lookarounds.
+             *
+             * The analysis is conservative, repetitions without upper bound,
+             * back references, unknown constructs and syntax errors are
+             * treated as unbounded.
+             *
+             * @param regex The regular expression in perl syntax
+             * @return The maximum length of a match or UNBOUNDED
+             */
+            static long get_max_length(const std::string& regex);
+
+        private:
+            /**
+             * @brief Construct an analyzer for a regular expression.
+             *
+             * @param regex The regular expression in perl syntax
+             */
+            match_span(const std::string& regex);
+
+            /**
+             * @brief Analyze alternatives up to the end of the group.
+             *
+             * @return The maximum length of all alternatives
+             */
+            long parse_alternation();
+
+            /**
+             * @brief Analyze a sequence of atoms up to the next alternative.
+             *
+             * @return The sum of the maximum lengths of all atoms
+             */
+            long parse_sequence();
+
+            /**
+             * @brief Analyze a single atom without its quantifier.
+             *
+             * @return The maximum length of the atom
+             */
+            long parse_atom();
+
+            /**
+             * @brief Analyze a group that starts after the opening bracket.
+             *
+             * @return The maximum length of the group
+             */
+            long parse_group();
+
+            /**
+             * @brief Skip a character class that starts after the opening
+             *  bracket.
+             *
+             * @return The length of a single character
+             */
+            long parse_class();
+
+            /**
+             * @brief Analyze an escape sequence outside of a class.
+             *
+             * @return Zero for assertions and one for characters
+             */
+            long parse_escape();
+
+            /**
+             * @brief Analyze a quantifier after an atom if there is one.
+             *
+             * @return The maximum number of repetitions of the atom
+             */
+            long parse_quantifier();
+
+            /**
+             * @brief Add two lengths.
+             *
+             * @param a The first length
+             * @param b The second length
+             * @return The sum or UNBOUNDED if it exceeds the limit
+             */
+            static long add(long a, long b);
+
+            /**
+             * @brief Multiply two lengths.
+             *
+             * @param a The first length
+             * @param b The second length
+             * @return The product or UNBOUNDED if it exceeds the limit
+             */
+            static long multiply(long a, long b);
+
+            /**
+             * @brief The regular expression.
+             */
+            const std::string& regex_;
+
+            /**
+             * @brief The position of the analysis in the regular expression.
+             */
+            std::size_t pos_ = 0;
+
+            /**
+             * @brief False if the regular expression could not be analyzed.
+             */
+            bool valid_ = true;
+    };
+}
+
+#endif /* MATCH_SPAN_H */
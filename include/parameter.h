@@ -57,7 +57,7 @@ namespace swd {
              *
              * @return The path of the parameter
              */
-            std::string get_path() const;
+            const std::string& get_path() const;
 
             /**
              * @brief Get the value of the parameter.
@@ -71,7 +71,7 @@ namespace swd {
              *
              * @return The raw value of the parameter
              */
-            std::string get_value() const;
+            const std::string& get_value() const;
 
             /**
              * @brief Add a (matching) blacklist filter to this parameter.
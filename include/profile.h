@@ -32,6 +32,7 @@
 #ifndef PROFILE_H
 #define PROFILE_H
 
+#include <set>
 #include <string>
 #include <boost/shared_ptr.hpp>
 
@@ -53,7 +54,7 @@ namespace swd {
              *
              * @return The allowed ips of the http server/shadowd clients
              */
-            std::string get_server_ip() const;
+            const std::string& get_server_ip() const;
 
             /**
              * @brief Set the id the profile.
@@ -156,7 +157,7 @@ namespace swd {
              *
              * @return The hmac key the client has to use
              */
-            std::string get_key() const;
+            const std::string& get_key() const;
 
             /**
              * @brief Set the global blacklist threshold for the profile.
@@ -190,6 +191,20 @@ namespace swd {
              */
             bool is_cache_outdated() const;
 
+            /**
+             * @brief Disable the blacklist filters with a tag.
+             *
+             * @param tag_id The id of the tag
+             */
+            void add_disabled_tag(const unsigned long long& tag_id);
+
+            /**
+             * @brief Get the tags whose blacklist filters are disabled.
+             *
+             * @return The ids of the disabled tags
+             */
+            const std::set<unsigned long long>& get_disabled_tags() const;
+
         private:
             /**
              * @brief The allowed ips of the http server/shadowd client.
@@ -241,6 +256,11 @@ namespace swd {
              */
             bool cache_outdated_;
 
+            /**
+             * @brief The ids of the tags whose blacklist filters are disabled.
+             */
+            std::set<unsigned long long> disabled_tags_;
+
     };
 
     /**
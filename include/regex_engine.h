@@ -0,0 +1,160 @@
+/**
+ * Shadow Daemon -- Web Application Firewall
+ *
+ *   Copyright (C) 2014-2022 Hendrik Buchwald <hb@zecure.org>
+ *
+ * This file is part of Shadow Daemon. Shadow Daemon is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, version 2.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#ifndef REGEX_ENGINE_H
+#define REGEX_ENGINE_H
+
+#include <string>
+#include <vector>
+#include <boost/shared_ptr.hpp>
+
+namespace swd {
+    class regex_engine;
+
+    /**
+     * @brief Compiled regular expression pointer.
+     */
+    using regex_engine_ptr = boost::shared_ptr<const swd::regex_engine>;
+
+    /**
+     * @brief Interface of the libraries that match the regular expressions of
+     *  the filters.
+     *
+     * Boost is always available and compatible with all existing filters. It
+     * throws an exception if the backtracking gets out of hand. RE2 guarantees
+     * linear time, but it does not support backreferences and lookarounds.
+     * PCRE2 compiles the expressions to machine code with its JIT. Which
+     * libraries are available depends on the build.
+     */
+    class regex_engine {
+        public:
+            /**
+             * @brief Destroy the compiled regular expression.
+             */
+            virtual ~regex_engine() = default;
+
+            /**
+             * @brief Test if the regular expression matches somewhere in the input.
+             *
+             * @param input The string that should be tested
+             * @return The result of the test
+             * @throw std::runtime_error If the engine gives up, e.g. because of
+             *  catastrophic backtracking
+             */
+            bool search(const std::string& input) const;
+
+            /**
+             * @brief Test if the regular expression matches inside a window of
+             *  the input.
+             *
+             * The characters around the window are only used as context for
+             * assertions like \b, so a match has to start and end inside of
+             * the window. Anchors at the end of the input do not match at a
+             * window end that is not the end of the input.
+             *
+             * @param input The string that contains the window
+             * @param begin The offset of the first character of the window
+             * @param end The offset behind the last character of the window
+             * @return The result of the test
+             * @throw std::runtime_error If the engine gives up, e.g. because of
+             *  catastrophic backtracking
+             */
+            virtual bool search(const std::string& input, std::size_t begin,
+             std::size_t end) const = 0;
+
+            /**
+             * @brief Compile a regular expression with the default engine.
+             *
+             * Expressions are always compiled like boost does it by default,
+             * so that the dot matches newlines and the anchors ^ and $ also
+             * match at line breaks.
+             * If the default engine can not compile the expression boost is
+             * used instead, so that no filter gets lost.
+             *
+             * @param regex The regular expression in perl syntax
+             * @param icase True if the expression should ignore the case
+             * @return The compiled regular expression
+             * @throw std::runtime_error If the engine can not compile the expression
+             */
+            static swd::regex_engine_ptr compile(const std::string& regex, bool icase);
+
+            /**
+             * @brief Compile a regular expression with a specific engine.
+             *
+             * @param type The name of the engine
+             * @param regex The regular expression in perl syntax
+             * @param icase True if the expression should ignore the case
+             * @return The compiled regular expression
+             * @throw std::runtime_error If the engine can not compile the expression
+             */
+            static swd::regex_engine_ptr compile(const std::string& type,
+             const std::string& regex, bool icase);
+
+            /**
+             * @brief Set the engine that is used for new filters.
+             *
+             * It has to be set before the worker threads are started.
+             *
+             * @param type The name of the engine
+             */
+            static void set_default_type(const std::string& type);
+
+            /**
+             * @brief Get the engine that is used for new filters.
+             *
+             * @return The name of the engine
+             */
+            static const std::string& get_default_type();
+
+            /**
+             * @brief Get the engines that are available in this build.
+             *
+             * @return The names of the engines
+             */
+            static std::vector<std::string> get_types();
+
+            /**
+             * @brief Check if an engine is available in this build.
+             *
+             * @param type The name of the engine
+             * @return True if the engine can be used
+             */
+            static bool is_available(const std::string& type);
+
+        private:
+            /**
+             * @brief The name of the engine that is used for new filters.
+             */
+            static std::string default_type_;
+    };
+}
+
+#endif /* REGEX_ENGINE_H */
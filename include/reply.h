@@ -71,7 +71,7 @@ namespace swd {
              *
              * @return The status message of the reply
              */
-            std::string get_message() const;
+            const std::string& get_message() const;
 
             /**
              * @brief Set a list of threat paths.
@@ -84,17 +84,45 @@ namespace swd {
             /**
              * @brief Get the list of threat paths.
              */
-            std::vector<std::string> get_threats() const;
+            const std::vector<std::string>& get_threats() const;
 
             /**
-             * @brief Set the content that gets send back to the http server.
+             * @brief Drop the encoded content but keep its memory for the next
+             *  reply.
+             */
+            void clear_content();
+
+            /**
+             * @brief Get the buffer for the dynamic parts of the encoded content.
+             *
+             * @return The reusable buffer of the reply
+             */
+            std::string& get_buffer();
+
+            /**
+             * @brief Append a segment of memory to the encoded content.
+             *
+             * The memory is not copied, so it has to be static or owned by the
+             * reply.
              *
-             * @param content The output content
+             * @param data The start of the segment
+             * @param length The length of the segment
              */
-            void set_content(const std::string& content);
+            void add_segment(const char* data, std::size_t length);
 
             /**
-             * @brief Get the content that gets send back to the http server.
+             * @brief Append a part of the reusable buffer to the encoded content.
+             *
+             * Offsets are used because the buffer might still grow.
+             *
+             * @param offset The start of the part in the buffer
+             * @param length The length of the part
+             */
+            void add_buffer_segment(std::size_t offset, std::size_t length);
+
+            /**
+             * @brief Get a copy of the content that gets send back to the http
+             *  server.
              *
              * @return The output content
              */
@@ -109,9 +137,20 @@ namespace swd {
              *
              * @return The output that gets send back to the http server
              */
-            std::vector<boost::asio::const_buffer> to_buffers() const;
+            const std::vector<boost::asio::const_buffer>& to_buffers();
 
         private:
+            /**
+             * @brief A segment of the encoded content.
+             *
+             * If data is a null pointer the offset refers to the buffer.
+             */
+            struct segment {
+                const char* data;
+                std::size_t offset;
+                std::size_t length;
+            };
+
             /**
              * @brief The status of the reply.
              */
@@ -128,9 +167,19 @@ namespace swd {
             std::vector<std::string> threats_;
 
             /**
-             * @brief The json-encoded content of the reply.
+             * @brief The reusable buffer for the dynamic parts of the content.
+             */
+            std::string buffer_;
+
+            /**
+             * @brief The segments of the json-encoded content in order.
+             */
+            std::vector<segment> segments_;
+
+            /**
+             * @brief The asio buffers of the segments.
              */
-            std::string content_;
+            std::vector<boost::asio::const_buffer> buffers_;
     };
 
     /**
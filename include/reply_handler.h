@@ -32,6 +32,8 @@
 #ifndef REPLY_HANDLER_H
 #define REPLY_HANDLER_H
 
+#include <string>
+
 #include "reply.h"
 
 namespace swd {
@@ -51,11 +53,31 @@ namespace swd {
              * @brief Encode the data of the reply with json and save the
              *  encoded version in the reply.
              *
+             * Replies with only a status use prebuilt frames, everything else
+             * is written into the reusable buffer of the reply.
+             *
              * @return The status of the encoding
              */
             bool encode() const;
 
         private:
+            /**
+             * @brief Check if a string contains characters that have to be
+             *  escaped in json.
+             *
+             * @param input The string that gets checked
+             * @return True if the string has to be escaped
+             */
+            static bool needs_escaping(const std::string& input);
+
+            /**
+             * @brief Append a string as quoted and escaped json string.
+             *
+             * @param output The string that gets extended
+             * @param input The string that gets encoded
+             */
+            static void append_quoted(std::string& output, const std::string& input);
+
             /**
              * @brief reply The pointer to the reply object.
              */
@@ -32,6 +32,8 @@
 #ifndef REQUEST_H
 #define REQUEST_H
 
+#include <memory>
+#include <memory_resource>
 #include <string>
 #include <boost/shared_ptr.hpp>
 
@@ -39,6 +41,7 @@
 #include "parameter.h"
 #include "hash.h"
 #include "integrity_rule.h"
+#include "hmac.h"
 
 namespace swd {
     /**
@@ -46,10 +49,14 @@ namespace swd {
      *
      * In contrast to most other model classes in this project the request does
      * not have all of his information at the time of construction. Instead first
-     * the signature and raw content get appended character by character. After
+     * the signature and raw content get appended chunk by chunk. After
      * that is done the signature gets checked and the raw content gets decoded.
      * If there was no error this is the point where the request object contains
      * all of its information in a clear format.
+     *
+     * Parameters and hashes that are added by value are allocated in an arena
+     * that belongs to the request and is released at once together with it.
+     * They must not outlive the request.
      */
     class request {
         public:
@@ -82,6 +89,11 @@ namespace swd {
              */
             void add_parameter(const std::string& path, const std::string& value);
 
+            /**
+             * @brief Remove all saved parameters.
+             */
+            void clear_parameters();
+
             /**
              * @brief Get all saved parameters.
              *
@@ -90,14 +102,42 @@ namespace swd {
             const swd::parameters& get_parameters() const;
 
             /**
-             * @brief Append a character to the content string.
+             * @brief Append a span of characters to the content string.
              *
              * This function is used by the request_parser to construct the raw
-             * content character by character.
+             * content chunk by chunk.
+             *
+             * @param begin The beginning of the characters that get appended
+             * @param end The end of the characters that get appended
+             */
+            void append_content(const char* begin, const char* end);
+
+            /**
+             * @brief Start calculating the hmac of the content while it arrives.
+             *
+             * Content that is already buffered is hashed right away, everything
+             * that gets appended later is hashed when it is appended.
              *
-             * @param input The character that gets appended
+             * @param keyed_hmac The hmac prepared with the key
+             * @param key The key that was used to prepare the hmac
              */
-            void append_content(const char& input);
+            void start_hmac(const swd::hmac& keyed_hmac, const std::string& key);
+
+            /**
+             * @brief Check if the hmac of the content is calculated with a key.
+             *
+             * @param key The expected key
+             * @return True if the running hmac uses exactly this key
+             */
+            bool has_hmac(const std::string& key) const;
+
+            /**
+             * @brief Finish the running hmac and compare it with a mac.
+             *
+             * @param mac The binary mac of the client
+             * @return True if the mac is valid
+             */
+            bool verify_hmac(const unsigned char* mac);
 
             /**
              * @brief Get the complete json content.
@@ -106,22 +146,45 @@ namespace swd {
              */
             void set_content(const std::string& content);
 
+            /**
+             * @brief Replace the content without copying it, for example with
+             *  the inflated version of compressed content.
+             *
+             * @param content The complete encoded content
+             */
+            void set_content(std::string&& content);
+
+            /**
+             * @brief Mark the content as compressed with deflate.
+             *
+             * @param compressed True if the content has to be inflated
+             */
+            void set_compressed(bool compressed);
+
+            /**
+             * @brief Check if the content is still compressed.
+             *
+             * @return True if the content has to be inflated before decoding
+             */
+            bool is_compressed() const;
+
             /**
              * @brief Set the complete json content.
              *
              * @return The complete encoded content.
              */
-            std::string get_content() const;
+            const std::string& get_content() const;
 
             /**
-             * @brief Append a character to the signature string.
+             * @brief Append a span of characters to the signature string.
              *
              * This function is used by the request_parser to construct the raw
-             * signature character by character.
+             * signature chunk by chunk.
              *
-             * @param input The character that gets appended
+             * @param begin The beginning of the characters that get appended
+             * @param end The end of the characters that get appended
              */
-            void append_signature(const char& input);
+            void append_signature(const char* begin, const char* end);
 
             /**
              * @brief Set the complete signature.
@@ -135,17 +198,18 @@ namespace swd {
              *
              * @return The complete signature.
              */
-            std::string get_signature() const;
+            const std::string& get_signature() const;
 
             /**
-             * @brief Append a character to the profile id.
+             * @brief Append a span of digits to the profile id.
              *
              * This function is used by the request_parser to construct the raw
-             * profile id character by character.
+             * profile id chunk by chunk.
              *
-             * @param input The character digit that gets appended
+             * @param begin The beginning of the digits that get appended
+             * @param end The end of the digits that get appended
              */
-            void append_profile_id(const char& input);
+            void append_profile_id(const char* begin, const char* end);
 
             /**
              * @brief Set the complete profile id.
@@ -173,7 +237,7 @@ namespace swd {
              *
              * @return The ip of the attacker
              */
-            std::string get_client_ip() const;
+            const std::string& get_client_ip() const;
 
             /**
              * @brief Set the caller of this request.
@@ -187,7 +251,7 @@ namespace swd {
              *
              * @return The caller
              */
-            std::string get_caller() const;
+            const std::string& get_caller() const;
 
             /**
              * @brief Set the resource of this request.
@@ -201,7 +265,7 @@ namespace swd {
              *
              * @return The resource
              */
-            std::string get_resource() const;
+            const std::string& get_resource() const;
 
             /**
              * @brief Add a (broken) integrity rule to this request.
@@ -240,6 +304,11 @@ namespace swd {
              */
             void add_hash(const std::string& algorithm, const std::string& digest);
 
+            /**
+             * @brief Remove all saved hashes.
+             */
+            void clear_hashes();
+
             /**
              * @brief Get all saved hashes.
              *
@@ -281,6 +350,13 @@ namespace swd {
             bool has_threats() const;
 
         private:
+            /**
+             * @brief The arena for all parameters and hashes of the request.
+             *
+             * It has to be declared first, so that it is destroyed last.
+             */
+            std::pmr::monotonic_buffer_resource arena_{4096};
+
             /**
              * @brief The pointer to the profile object.
              */
@@ -301,6 +377,21 @@ namespace swd {
              */
             std::string content_;
 
+            /**
+             * @brief The state of the compression of the content.
+             */
+            bool compressed_ = false;
+
+            /**
+             * @brief The running hmac of the content, if the key was known early.
+             */
+            std::unique_ptr<swd::hmac> hmac_;
+
+            /**
+             * @brief The key of the running hmac.
+             */
+            std::string hmac_key_;
+
             /**
              * @brief The signature of the request.
              */
@@ -38,6 +38,7 @@
 #include "request.h"
 #include "cache.h"
 #include "storage.h"
+#include "scan_pool.h"
 
 namespace swd {
     /**
@@ -62,12 +63,57 @@ namespace swd {
              */
             bool valid_signature() const;
 
+            /**
+             * @brief Set the security limits that are enforced while decoding.
+             *
+             * @param max_parameters The max number of parameters or -1
+             * @param max_length_path The max length of parameter paths or -1
+             * @param max_length_value The max length of parameter values or -1
+             * @param max_length_inflated The max length of inflated content or -1
+             */
+            void set_limits(int max_parameters, int max_length_path,
+             int max_length_value, int max_length_inflated = -1);
+
+            /**
+             * @brief Set if all blacklist filters are evaluated in active mode.
+             *
+             * @param full_scan False if the blacklist scan may stop as soon
+             *  as the threshold of a parameter is exceeded
+             */
+            void set_full_scan(bool full_scan);
+
+            /**
+             * @brief Set the size of the windows long values are scanned in.
+             *
+             * @param scan_window The size of a window or -1
+             * @param unbounded_span The assumed match span of filters without
+             *  an upper bound or -1
+             */
+            void set_scan_window(int scan_window, int unbounded_span = -1);
+
+            /**
+             * @brief Set the pool that splits the scans of large requests.
+             *
+             * @param scan_pool The pointer to the scan pool
+             */
+            void set_scan_pool(swd::scan_pool_ptr scan_pool);
+
             /**
              * @brief Decode the json string.
              *
-             * @return Status of decoding
+             * Compressed content is inflated first.
+             *
+             * @return STATUS_OK, STATUS_BAD_JSON or STATUS_BAD_REQUEST if a
+             *  security limit is exceeded
+             */
+            int decode();
+
+            /**
+             * @brief Get the reason why the request was rejected while decoding.
+             *
+             * @return The message or an empty string
              */
-            bool decode() const;
+            const std::string& get_message() const;
 
             /**
              * @brief Start the real processing of the request.
@@ -82,6 +128,26 @@ namespace swd {
             std::vector<std::string> get_threats() const;
 
         private:
+            /**
+             * @brief Replace the compressed content of the request with the
+             *  inflated content.
+             *
+             * @return STATUS_OK, STATUS_BAD_JSON if the content is corrupt or
+             *  STATUS_BAD_REQUEST if it is too long
+             */
+            int inflate();
+
+            /**
+             * @brief Decode a hex string with a fixed length.
+             *
+             * @param input The hex string
+             * @param output The buffer for the binary data
+             * @param length The expected number of bytes
+             * @return False if the string is not valid hex of the expected length
+             */
+            static bool decode_hex(const std::string& input,
+             unsigned char* output, std::size_t length);
+
             /**
              * @brief The pointer to the request object.
              */
@@ -96,6 +162,51 @@ namespace swd {
              * @brief The pointer to the storage object.
              */
             swd::storage_ptr storage_;
+
+            /**
+             * @brief The max number of parameters.
+             */
+            int max_parameters_ = -1;
+
+            /**
+             * @brief The max length of parameter paths.
+             */
+            int max_length_path_ = -1;
+
+            /**
+             * @brief The max length of parameter values.
+             */
+            int max_length_value_ = -1;
+
+            /**
+             * @brief The max length of inflated content.
+             */
+            int max_length_inflated_ = -1;
+
+            /**
+             * @brief False if the blacklist scan may stop early.
+             */
+            bool full_scan_ = true;
+
+            /**
+             * @brief The size of the blacklist scan windows or -1.
+             */
+            int scan_window_ = -1;
+
+            /**
+             * @brief The assumed match span of unbounded filters or -1.
+             */
+            int unbounded_span_ = -1;
+
+            /**
+             * @brief The pointer to the pool that splits large requests.
+             */
+            swd::scan_pool_ptr scan_pool_;
+
+            /**
+             * @brief The reason why the request was rejected while decoding.
+             */
+            std::string message_;
     };
 }
 
@@ -39,7 +39,16 @@
 
 namespace swd {
     /**
-     * @brief Parses the input of a client character by character.
+     * @brief Parses the input of a client.
+     *
+     * The input consists of three lines. Instead of looking at every character
+     * on its own the parser searches the line ends with memchr, which is
+     * vectorized by the C library, and hands complete spans to the request.
+     *
+     * If the profile id is followed by a comma and a length the content is
+     * compressed with deflate. Compressed content consists of exactly that
+     * many bytes followed by a line end, since it might contain line ends
+     * itself.
      */
     class request_parser {
         public:
@@ -53,44 +62,71 @@ namespace swd {
              *
              * The tribool return value is true when a complete request has been
              * parsed, false if the data is invalid, indeterminate when more data
-             * is required. The InputIterator return value indicates how much of
-             * the input has been consumed.
+             * is required. The pointer return value indicates how much of the
+             * input has been consumed.
              *
              * @param request The pointer to the request object
-             * @param begin The beginning of the input iterator
-             * @param end The end of the input iterator
+             * @param begin The beginning of the input
+             * @param end The end of the input
              */
-            template <typename InputIterator> boost::tuple<boost::tribool, InputIterator>
-             parse(const swd::request_ptr& request, InputIterator begin, InputIterator end) {
-                while (begin != end) {
-                    boost::tribool result = consume(request, *begin++);
+            boost::tuple<boost::tribool, const char*> parse(
+             const swd::request_ptr& request, const char* begin, const char* end);
 
-                    if (result || !result) {
-                        return boost::make_tuple(result, begin);
-                    }
-                }
-                boost::tribool result = boost::indeterminate;
-                return boost::make_tuple(result, begin);
-            }
+            /**
+             * @brief Check if the profile id is parsed completely.
+             *
+             * @return True if the first line is complete
+             */
+            bool has_profile_id() const;
 
         private:
             /**
-             * @brief Consume the next character of the input.
+             * @brief Check if a span only consists of decimal digits.
              *
-             * @param request The pointer to the request object
-             * @param input The current character
+             * @param begin The beginning of the span
+             * @param end The end of the span
+             */
+            static bool is_digits(const char* begin, const char* end);
+
+            /**
+             * @brief Check if a span only consists of alphanumeric characters.
+             *
+             * @param begin The beginning of the span
+             * @param end The end of the span
              */
-            boost::tribool consume(const swd::request_ptr& request,
-             const char& input);
+            static bool is_alnums(const char* begin, const char* end);
 
             /**
              * @brief The current state of the parser.
              */
             enum state {
                 profile,
+                content_length,
                 signature,
-                content
+                content,
+                compressed_content,
+                content_end
             } state_;
+
+            /**
+             * @brief The number of digits of the profile id so far.
+             */
+            std::size_t profile_id_length_ = 0;
+
+            /**
+             * @brief The number of characters of the signature so far.
+             */
+            std::size_t signature_length_ = 0;
+
+            /**
+             * @brief The number of digits of the compressed content length so far.
+             */
+            std::size_t content_length_digits_ = 0;
+
+            /**
+             * @brief The number of bytes of compressed content that are still missing.
+             */
+            std::size_t content_remaining_ = 0;
     };
 }
 
@@ -0,0 +1,169 @@
+/**
+ * Shadow Daemon -- Web Application Firewall
+ *
+ *   Copyright (C) 2014-2022 Hendrik Buchwald <hb@zecure.org>
+ *
+ * This file is part of Shadow Daemon. Shadow Daemon is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, version 2.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#ifndef SAFE_CHARS_H
+#define SAFE_CHARS_H
+
+#include <bitset>
+#include <string>
+
+namespace swd {
+    /**
+     * @brief Classifies strings and regular expressions by safe characters.
+     *
+     * Safe characters are letters, digits, the underscore, the hyphen and the
+     * dot. Numbers, identifiers, tokens and uuids consist only of them, but
+     * almost no blacklist filter can match without at least one character
+     * like a quote, a bracket or a semicolon.
+     */
+    class safe_chars {
+        public:
+            /**
+             * @brief Check if a span only consists of safe characters.
+             *
+             * The loop is branch free, so the compiler is able to vectorize it.
+             *
+             * @param begin The beginning of the span
+             * @param end The end of the span
+             * @return True if there is no other character in the span
+             */
+            static bool contains_only(const char* begin, const char* end);
+
+            /**
+             * @brief Check if a regular expression might match a string that
+             *  only consists of safe characters.
+             *
+             * The analysis is conservative, unknown constructs and syntax
+             * errors are treated as if they would match.
+             *
+             * @param regex The regular expression in perl syntax
+             * @return False if every match contains another character
+             */
+            static bool can_match(const std::string& regex);
+
+        private:
+            /**
+             * @brief A set of characters.
+             */
+            using char_set = std::bitset<256>;
+
+            /**
+             * @brief Construct an analyzer for a regular expression.
+             *
+             * @param regex The regular expression in perl syntax
+             */
+            safe_chars(const std::string& regex);
+
+            /**
+             * @brief Analyze alternatives up to the end of the group.
+             *
+             * @return True if one alternative can match safe characters only
+             */
+            bool parse_alternation();
+
+            /**
+             * @brief Analyze a sequence of atoms up to the next alternative.
+             *
+             * @return True if all atoms can match safe characters only
+             */
+            bool parse_sequence();
+
+            /**
+             * @brief Analyze a single atom without its quantifier.
+             *
+             * @return True if the atom can match safe characters only
+             */
+            bool parse_atom();
+
+            /**
+             * @brief Analyze a group that starts after the opening bracket.
+             *
+             * @return True if the group can match safe characters only
+             */
+            bool parse_group();
+
+            /**
+             * @brief Analyze a character class that starts after the opening
+             *  bracket.
+             *
+             * @return True if the class contains a safe character
+             */
+            bool parse_class();
+
+            /**
+             * @brief Get the characters of an escape sequence inside or
+             *  outside of a class.
+             *
+             * @param set The characters that are matched by the escape
+             * @return False if the escape is zero-width
+             */
+            bool parse_escape(char_set& set);
+
+            /**
+             * @brief Add the characters of the shorthand classes \d, \w and \s.
+             *
+             * @param c The letter of the shorthand class
+             * @param set The set that gets extended
+             */
+            static void add_shorthand(char c, char_set& set);
+
+            /**
+             * @brief Skip a quantifier after an atom if there is one.
+             *
+             * @return True if the quantifier allows zero repetitions
+             */
+            bool parse_quantifier();
+
+            /**
+             * @brief Get the set of safe characters.
+             *
+             * @return The set of letters, digits and the characters "_-."
+             */
+            static const char_set& get_safe_set();
+
+            /**
+             * @brief The regular expression.
+             */
+            const std::string& regex_;
+
+            /**
+             * @brief The position of the analysis in the regular expression.
+             */
+            std::size_t pos_ = 0;
+
+            /**
+             * @brief False if the regular expression could not be analyzed.
+             */
+            bool valid_ = true;
+    };
+}
+
+#endif /* SAFE_CHARS_H */
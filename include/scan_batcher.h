@@ -0,0 +1,186 @@
+/**
+ * Shadow Daemon -- Web Application Firewall
+ *
+ *   Copyright (C) 2014-2022 Hendrik Buchwald <hb@zecure.org>
+ *
+ * This file is part of Shadow Daemon. Shadow Daemon is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, version 2.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#ifndef SCAN_BATCHER_H
+#define SCAN_BATCHER_H
+
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include "blacklist_filter_set.h"
+
+namespace swd {
+    /**
+     * @brief Scans the strings of concurrent requests together.
+     *
+     * Every request normally runs all filters on its own strings. With many
+     * small requests the compiled filters are evicted from the cpu caches all
+     * the time. The batcher collects the strings of requests that arrive within
+     * a short window and runs every filter on all of them in a row.
+     *
+     * The first request of a batch becomes its leader. It waits until the
+     * window is over or until the batch is full and closes the batch. Then all
+     * requests of the batch take the filters one by one in the order of the
+     * set and run them on all strings, so the scan is spread over the threads
+     * of all requests. Strings whose threshold is exceeded already are skipped.
+     * There are no extra threads.
+     */
+    class scan_batcher :
+     private boost::noncopyable {
+        public:
+            /**
+             * @brief The function that evaluates a filter and updates its statistics.
+             *
+             * It gets the filter, the string, the folded string and a flag that
+             * is set to false if the filter was skipped. It returns true if the
+             * filter matches.
+             */
+            using evaluator = std::function<bool(const swd::blacklist_filter_ptr&,
+             const std::string&, const std::string&, bool&)>;
+
+            /**
+             * @brief Change the size of the window.
+             *
+             * @param window The max wait time of a batch in microseconds or -1
+             *  to disable batching
+             * @param max_inputs The max number of strings in a batch
+             */
+            void set_limits(int window, int max_inputs);
+
+            /**
+             * @brief Check if batching is enabled.
+             *
+             * @return True if there is a window
+             */
+            bool is_enabled() const;
+
+            /**
+             * @brief Get the indexes of all filters of a set that match the strings.
+             *
+             * @param filter_set The set of blacklist filters
+             * @param inputs The strings that should be tested
+             * @param thresholds The impact per string after that the remaining
+             *  filters are skipped or -1 to evaluate all filters
+             * @param evaluate The function that evaluates a filter
+             * @param matches The sorted indexes of the matching filters per string
+             * @param complete True per string if no filter was skipped
+             */
+            void match(const swd::blacklist_filter_set_ptr& filter_set,
+             const std::vector<const std::string*>& inputs, const std::vector<int>& thresholds,
+             const evaluator& evaluate, std::vector<std::vector<unsigned int>>& matches,
+             std::vector<bool>& complete);
+
+        private:
+            /**
+             * @brief The strings of the requests that are scanned together.
+             */
+            struct batch {
+                swd::blacklist_filter_set_ptr filter_set;
+                swd::filter_order_ptr order;
+                std::vector<const std::string*> inputs;
+                std::vector<const std::string*> folded;
+                std::vector<bool> safe;
+                std::vector<int> thresholds;
+                std::unique_ptr<std::atomic<unsigned int>[]> impacts;
+                std::vector<std::vector<std::size_t>> hits;
+                std::vector<std::vector<std::size_t>> skipped;
+                std::atomic<std::size_t> next{0};
+                std::size_t finished = 0;
+                bool closed = false;
+                bool done = false;
+                std::exception_ptr error;
+            };
+
+            /**
+             * @brief Stop adding strings to a batch and prepare its scan.
+             *
+             * The mutex has to be locked by the caller.
+             *
+             * @param own_batch The batch that is closed
+             */
+            void close(batch& own_batch);
+
+            /**
+             * @brief Take filters of a closed batch and run them on all strings
+             *  until no filter is left, then wait for the other requests.
+             *
+             * The mutex has to be locked by the caller, it is released while
+             * the filters are evaluated.
+             *
+             * @param own_batch The batch that is scanned
+             * @param evaluate The function that evaluates a filter
+             * @param scoped_lock The lock of the mutex
+             */
+            void work(batch& own_batch, const evaluator& evaluate,
+             boost::unique_lock<boost::mutex>& scoped_lock);
+
+            /**
+             * @brief The batch that collects strings right now.
+             */
+            boost::shared_ptr<batch> current_;
+
+            /**
+             * @brief Mutex for the current batch.
+             */
+            boost::mutex mutex_;
+
+            /**
+             * @brief Wakes up leaders of full batches and requests of closed
+             *  or finished batches.
+             */
+            boost::condition_variable changed_;
+
+            /**
+             * @brief The max wait time of a batch in microseconds or -1.
+             */
+            int window_ = -1;
+
+            /**
+             * @brief The max number of strings in a batch.
+             */
+            std::size_t max_inputs_ = 64;
+    };
+
+    /**
+     * @brief Scan batcher pointer.
+     */
+    using scan_batcher_ptr = boost::shared_ptr<swd::scan_batcher>;
+}
+
+#endif /* SCAN_BATCHER_H */
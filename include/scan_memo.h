@@ -0,0 +1,158 @@
+/**
+ * Shadow Daemon -- Web Application Firewall
+ *
+ *   Copyright (C) 2014-2022 Hendrik Buchwald <hb@zecure.org>
+ *
+ * This file is part of Shadow Daemon. Shadow Daemon is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, version 2.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#ifndef SCAN_MEMO_H
+#define SCAN_MEMO_H
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <boost/thread/mutex.hpp>
+#include <boost/shared_ptr.hpp>
+
+namespace swd {
+    /**
+     * @brief Remembers which filters matched a string.
+     *
+     * Most requests repeat the same paths and many short values, so it is not
+     * necessary to run every filter on them again. The entries are keyed by a
+     * keyed siphash of the filter set generation and the string. The string is
+     * stored as well and compared on every hit, so a collision is only a miss.
+     *
+     * The table is split into shards with their own mutexes to keep lock
+     * contention low. Every shard holds a fixed number of entries, if it is
+     * full an arbitrary entry is replaced.
+     */
+    class scan_memo {
+        public:
+            /**
+             * @brief Construct the memo table.
+             *
+             * @param capacity The max number of entries or -1 to disable it
+             */
+            scan_memo(int capacity = -1);
+
+            /**
+             * @brief Change the max number of entries and drop all entries.
+             *
+             * This is not synchronized with lookups, so it is only used when
+             * the server is initialized.
+             *
+             * @param capacity The max number of entries or -1 to disable it
+             */
+            void set_capacity(int capacity);
+
+            /**
+             * @brief Look up the matching filters of a string.
+             *
+             * @param generation The generation of the filter set
+             * @param input The string that was scanned
+             * @param matches The indexes of the matching filters
+             * @return True if the string is known
+             */
+            bool find(unsigned long long generation, const std::string& input,
+             std::vector<unsigned int>& matches);
+
+            /**
+             * @brief Save the matching filters of a string.
+             *
+             * @param generation The generation of the filter set
+             * @param input The string that was scanned
+             * @param matches The indexes of the matching filters
+             */
+            void add(unsigned long long generation, const std::string& input,
+             const std::vector<unsigned int>& matches);
+
+            /**
+             * @brief Get the number of entries.
+             *
+             * @return The number of entries in all shards
+             */
+            std::size_t get_size();
+
+        private:
+            /**
+             * @brief An entry of the memo table.
+             */
+            struct entry {
+                unsigned long long generation;
+                std::string input;
+                std::vector<unsigned int> matches;
+            };
+
+            /**
+             * @brief A part of the memo table with its own lock.
+             */
+            struct shard {
+                boost::mutex mutex;
+                std::unordered_map<std::uint64_t, entry> entries;
+            };
+
+            /**
+             * @brief Hash the generation and the string with the secret key.
+             *
+             * @param generation The generation of the filter set
+             * @param input The string that was scanned
+             * @return The siphash-2-4 of the input
+             */
+            std::uint64_t hash(unsigned long long generation, const std::string& input) const;
+
+            /**
+             * @brief The number of shards, has to be a power of two.
+             */
+            static const std::size_t shard_count = 16;
+
+            /**
+             * @brief The shards of the memo table.
+             */
+            std::array<shard, shard_count> shards_;
+
+            /**
+             * @brief The max number of entries per shard.
+             */
+            std::size_t shard_capacity_ = 0;
+
+            /**
+             * @brief The random key of the hash, so that collisions can not be
+             *  predicted.
+             */
+            std::uint64_t key_[2];
+    };
+
+    /**
+     * @brief Scan memo pointer.
+     */
+    using scan_memo_ptr = boost::shared_ptr<swd::scan_memo>;
+}
+
+#endif /* SCAN_MEMO_H */
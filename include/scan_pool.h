@@ -0,0 +1,136 @@
+/**
+ * Shadow Daemon -- Web Application Firewall
+ *
+ *   Copyright (C) 2014-2022 Hendrik Buchwald <hb@zecure.org>
+ *
+ * This file is part of Shadow Daemon. Shadow Daemon is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, version 2.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#ifndef SCAN_POOL_H
+#define SCAN_POOL_H
+
+#include <functional>
+#include <memory>
+#include <boost/asio.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "parameter.h"
+
+namespace swd {
+    /**
+     * @brief Splits the scan of large requests between threads.
+     *
+     * Small requests are scanned inline by their analysis thread. If the paths
+     * and values of a request exceed a size threshold its parameters are handed
+     * out one by one to the caller and to helper threads. Every thread takes
+     * the next parameter as soon as it is done with the last one, so a long
+     * value does not hold up the others. A request with a single parameter
+     * hands out its filters instead. The caller works on the tasks as well,
+     * so the scan finishes even if all helpers are busy.
+     */
+    class scan_pool :
+     private boost::noncopyable {
+        public:
+            /**
+             * @brief Construct the pool without threads.
+             */
+            scan_pool();
+
+            /**
+             * @brief Start the helper threads.
+             *
+             * @param thread_pool_size The number of helper threads
+             */
+            void start(std::size_t thread_pool_size);
+
+            /**
+             * @brief Stop the helper threads and wait for them to exit.
+             */
+            void stop();
+
+            /**
+             * @brief Set the size from which on requests are split.
+             *
+             * @param size The min total length of all paths and values or -1
+             *  to never split requests
+             */
+            void set_threshold(int size);
+
+            /**
+             * @brief Check if the scan of parameters is worth to be split.
+             *
+             * @param parameters The parameters of a request
+             * @return True if there are helpers and the parameters are large
+             */
+            bool should_split(const swd::parameters& parameters) const;
+
+            /**
+             * @brief Execute a task for every index and wait for all of them.
+             *
+             * If a task throws an exception the other tasks are still executed
+             * and the first exception is rethrown afterwards.
+             *
+             * @param count The number of tasks
+             * @param task The function that executes the task with an index
+             */
+            void run(std::size_t count, const std::function<void(std::size_t)>& task);
+
+        private:
+            /**
+             * @brief The io_service that holds the queue.
+             */
+            boost::asio::io_service io_service_;
+
+            /**
+             * @brief Keeps the helpers alive while the queue is empty.
+             */
+            std::unique_ptr<boost::asio::io_service::work> work_;
+
+            /**
+             * @brief The helper threads.
+             */
+            boost::thread_group threads_;
+
+            /**
+             * @brief The number of helper threads.
+             */
+            std::size_t thread_pool_size_ = 0;
+
+            /**
+             * @brief The min total length of all paths and values or -1.
+             */
+            int threshold_ = -1;
+    };
+
+    /**
+     * @brief Scan pool pointer.
+     */
+    using scan_pool_ptr = boost::shared_ptr<swd::scan_pool>;
+}
+
+#endif /* SCAN_POOL_H */
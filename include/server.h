@@ -35,11 +35,16 @@
 #include <boost/asio.hpp>
 #include <boost/asio/ssl.hpp>
 #include <boost/noncopyable.hpp>
+#include <boost/make_shared.hpp>
 #include <boost/shared_ptr.hpp>
 
 #include "connection.h"
 #include "storage.h"
 #include "cache.h"
+#include "buffer_pool.h"
+#include "admission.h"
+#include "analysis_pool.h"
+#include "scan_pool.h"
 
 namespace swd {
     /**
@@ -67,14 +72,30 @@ namespace swd {
             void init();
 
             /**
-             * @brief Add threads to the thread pool and start accepting connections.
+             * @brief Add threads to the thread pools and start accepting connections.
              *
-             * @param thread_pool_size The number of threads that should be
-             *  added to the thread pool
+             * @param thread_pool_size The number of io threads that accept
+             *  connections and read and write data
+             * @param analysis_pool_size The number of threads that analyze
+             *  requests
+             * @param scan_pool_size The number of threads that help to scan
+             *  large requests
              */
-            void start(std::size_t thread_pool_size);
+            void start(std::size_t thread_pool_size, std::size_t analysis_pool_size,
+             std::size_t scan_pool_size);
 
         private:
+            /**
+             * @brief Load the blacklist filters and report which filters the
+             *  available regex engines can not compile.
+             */
+            void check_regex_engines();
+
+            /**
+             * @brief Configure the ssl session cache and session tickets.
+             */
+            void init_ssl_sessions();
+
             /**
              * @brief Initiate an asynchronous accept operation.
              */
@@ -95,6 +116,11 @@ namespace swd {
              */
             void handle_reload();
 
+            /**
+             * @brief Handle a request to report the statistics of the filters.
+             */
+            void handle_stats();
+
             /**
              * @brief The io_service used to perform asynchronous operations.
              */
@@ -112,6 +138,12 @@ namespace swd {
              */
             boost::asio::signal_set signals_reload_;
 
+            /**
+             * @brief The signal_set is used to register for statistics
+             *  notifications.
+             */
+            boost::asio::signal_set signals_stats_;
+
             /**
              * @brief Acceptor used to listen for incoming connections.
              */
@@ -141,6 +173,26 @@ namespace swd {
              * @brief The pointer to the cache object.
              */
             swd::cache_ptr cache_;
+
+            /**
+             * @brief The pool of read buffers that is shared by all connections.
+             */
+            swd::buffer_pool_ptr buffer_pool_ = boost::make_shared<swd::buffer_pool>();
+
+            /**
+             * @brief The admission control shared by all connections.
+             */
+            swd::admission_ptr admission_ = boost::make_shared<swd::admission>();
+
+            /**
+             * @brief The threads that analyze the requests of all connections.
+             */
+            swd::analysis_pool_ptr analysis_pool_ = boost::make_shared<swd::analysis_pool>();
+
+            /**
+             * @brief The threads that help to scan large requests.
+             */
+            swd::scan_pool_ptr scan_pool_ = boost::make_shared<swd::scan_pool>();
     };
 }
 
@@ -43,6 +43,7 @@ typedef unsigned char byte;
 #define STATUS_BAD_JSON 4
 #define STATUS_ATTACK 5
 #define STATUS_CRITICAL_ATTACK 6
+#define STATUS_OVERLOADED 7
 
 #define STATUS_ACTIVATED 1
 #define STATUS_DEACTIVATED 2
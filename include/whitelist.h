@@ -34,6 +34,7 @@
 
 #include "request.h"
 #include "cache.h"
+#include "scan_pool.h"
 
 namespace swd {
     /**
@@ -45,8 +46,9 @@ namespace swd {
              * @brief Construct the whitelist.
              *
              * @param cache The pointer to the cache object
+             * @param scan_pool The pointer to the pool that splits large requests
              */
-            whitelist(swd::cache_ptr cache);
+            whitelist(swd::cache_ptr cache, swd::scan_pool_ptr scan_pool = swd::scan_pool_ptr());
 
             /**
              * @brief Scan all parameters in the request and add connections to
@@ -57,10 +59,26 @@ namespace swd {
             void scan(const swd::request_ptr& request) const;
 
         private:
+            /**
+             * @brief Check a parameter against its rules and add connections
+             *  to broken rules.
+             *
+             * @param request The pointer to the request object
+             * @param parameter The pointer to the parameter object
+             * @param folded The buffer for the lowercase version of the value
+             */
+            void scan_parameter(const swd::request_ptr& request,
+             const swd::parameter_ptr& parameter, std::string& folded) const;
+
             /**
              * @brief The pointer to the cache object.
              */
             swd::cache_ptr cache_;
+
+            /**
+             * @brief The pointer to the pool that splits large requests.
+             */
+            swd::scan_pool_ptr scan_pool_;
     };
 }
 
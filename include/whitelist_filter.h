@@ -34,9 +34,10 @@
 
 #include <vector>
 #include <string>
-#include <boost/regex.hpp>
 #include <boost/shared_ptr.hpp>
 
+#include "regex_engine.h"
+
 namespace swd {
     /**
      * @brief Models a whitelist filter.
@@ -75,6 +76,16 @@ namespace swd {
              */
             bool matches(const std::string& input) const;
 
+            /**
+             * @brief Test for input if the filter matches, using the folded
+             *  input if the filter was folded.
+             *
+             * @param input The string that should be tested
+             * @param folded The same string folded to lowercase
+             * @return The status of the regular expression test
+             */
+            bool matches(const std::string& input, const std::string& folded) const;
+
         private:
             /**
              * @brief The database id of the filter.
@@ -84,7 +95,17 @@ namespace swd {
             /**
              * @brief The regular expression of the filter.
              */
-            boost::regex regex_;
+            std::string regex_;
+
+            /**
+             * @brief The compiled regular expression of the filter.
+             */
+            swd::regex_engine_ptr engine_;
+
+            /**
+             * @brief True if the regular expression is folded and case-sensitive.
+             */
+            bool folded_ = false;
     };
 
     /**
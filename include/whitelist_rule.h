@@ -88,6 +88,16 @@ namespace swd {
              */
             bool is_adhered_to(const std::string& value) const;
 
+            /**
+             * @brief Test for value if the filter matches and if the length is
+             *  acceptable, with a value that is already folded to lowercase.
+             *
+             * @param value The string that should be tested
+             * @param folded The same string folded to lowercase
+             * @return The status of the regular expression and length test
+             */
+            bool is_adhered_to(const std::string& value, const std::string& folded) const;
+
         private:
             /**
              * @brief The database id of the rule.
@@ -77,6 +77,16 @@ CREATE TABLE profiles (
 
 CREATE INDEX idx_profiles ON profiles (server_ip);
 
+CREATE TABLE tags_profiles (
+    tag_id        INTEGER UNSIGNED NOT NULL,
+    profile_id    INTEGER UNSIGNED NOT NULL,
+    CONSTRAINT fk_tags_profiles1 FOREIGN KEY (tag_id) REFERENCES tags (id) ON DELETE CASCADE,
+    CONSTRAINT fk_tags_profiles2 FOREIGN KEY (profile_id) REFERENCES profiles (id) ON DELETE CASCADE,
+    PRIMARY KEY (tag_id, profile_id)
+);
+
+CREATE INDEX idx_tags_profiles1 ON tags_profiles (profile_id);
+
 CREATE TABLE requests (
     id                    INTEGER UNSIGNED NOT NULL AUTO_INCREMENT primary key,
     profile_id            INTEGER UNSIGNED NOT NULL,
@@ -0,0 +1,9 @@
+CREATE TABLE tags_profiles (
+    tag_id        INTEGER UNSIGNED NOT NULL,
+    profile_id    INTEGER UNSIGNED NOT NULL,
+    CONSTRAINT fk_tags_profiles1 FOREIGN KEY (tag_id) REFERENCES tags (id) ON DELETE CASCADE,
+    CONSTRAINT fk_tags_profiles2 FOREIGN KEY (profile_id) REFERENCES profiles (id) ON DELETE CASCADE,
+    PRIMARY KEY (tag_id, profile_id)
+);
+
+CREATE INDEX idx_tags_profiles1 ON tags_profiles (profile_id);
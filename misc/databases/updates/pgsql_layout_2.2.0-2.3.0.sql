@@ -0,0 +1,9 @@
+CREATE TABLE tags_profiles (
+	tag_id		integer NOT NULL,
+	profile_id	integer NOT NULL,
+	FOREIGN KEY (tag_id) REFERENCES tags (id) ON DELETE CASCADE,
+	FOREIGN KEY (profile_id) REFERENCES profiles (id) ON DELETE CASCADE,
+	PRIMARY KEY (tag_id, profile_id)
+);
+
+CREATE INDEX ON tags_profiles (profile_id);
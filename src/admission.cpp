@@ -0,0 +1,216 @@
+/**
+ * Shadow Daemon -- Web Application Firewall
+ *
+ *   Copyright (C) 2014-2022 Hendrik Buchwald <hb@zecure.org>
+ *
+ * This file is part of Shadow Daemon. Shadow Daemon is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, version 2.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#include <algorithm>
+#include <utility>
+
+#include "admission.h"
+
+/* The maximum number of sources with their own bucket. */
+#define MAX_BUCKETS 65536
+
+/* The number of nanoseconds between two reports of shed requests. */
+#define SHED_INTERVAL 1000000000LL
+
+void swd::admission::set_limits(int max_connections, int max_analyses,
+ int rate_limit, int rate_burst, int max_failures) {
+    max_connections_ = max_connections;
+    max_analyses_ = max_analyses;
+    rate_limit_ = rate_limit;
+    rate_burst_ = std::max(rate_burst, 1);
+    max_failures_ = max_failures;
+}
+
+bool swd::admission::add_connection(const boost::asio::ip::address& address) {
+    int connections = ++connections_;
+
+    if ((max_connections_ > -1) && (connections > max_connections_)) {
+        return false;
+    }
+
+    if (rate_limit_ > -1) {
+        return take_token(address);
+    }
+
+    return true;
+}
+
+void swd::admission::remove_connection() {
+    --connections_;
+}
+
+bool swd::admission::add_analysis() {
+    int analyses = ++analyses_;
+
+    if ((max_analyses_ > -1) && (analyses > max_analyses_)) {
+        --analyses_;
+        return false;
+    }
+
+    return true;
+}
+
+void swd::admission::remove_analysis() {
+    --analyses_;
+}
+
+int swd::admission::get_connections() const {
+    return connections_;
+}
+
+int swd::admission::get_analyses() const {
+    return analyses_;
+}
+
+unsigned long swd::admission::count_shed() {
+    ++shed_;
+
+    long long now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()
+    ).count();
+
+    long long last = shed_reported_.load(std::memory_order_relaxed);
+
+    /* Only one of the concurrent requests reports the accumulated count. */
+    if (((last != 0) && ((now - last) < SHED_INTERVAL))
+     || !shed_reported_.compare_exchange_strong(last, now)) {
+        return 0;
+    }
+
+    return shed_.exchange(0);
+}
+
+void swd::admission::add_failure(const boost::asio::ip::address& address) {
+    if (max_failures_ < 0) {
+        return;
+    }
+
+    boost::unique_lock scoped_lock(failures_mutex_);
+
+    /* Every failure costs a token, the bucket is refilled within a minute. */
+    bucket* failures = get_bucket(failures_, address, max_failures_ / 60.0,
+     std::max(max_failures_, 1), true);
+
+    failures->tokens = std::max(failures->tokens - 1, 0.0);
+}
+
+bool swd::admission::is_blocked(const boost::asio::ip::address& address) {
+    if (max_failures_ < 0) {
+        return false;
+    }
+
+    boost::unique_lock scoped_lock(failures_mutex_);
+
+    bucket* failures = get_bucket(failures_, address, max_failures_ / 60.0,
+     std::max(max_failures_, 1), false);
+
+    return (failures && (failures->tokens < 1));
+}
+
+bool swd::admission::take_token(const boost::asio::ip::address& address) {
+    boost::unique_lock scoped_lock(buckets_mutex_);
+
+    bucket* requests = get_bucket(buckets_, address, rate_limit_, rate_burst_, true);
+
+    if (requests->tokens < 1) {
+        return false;
+    }
+
+    requests->tokens -= 1;
+
+    return true;
+}
+
+swd::admission::bucket* swd::admission::get_bucket(bucket_table& buckets,
+ const boost::asio::ip::address& address, double rate, double burst,
+ bool create) {
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+    auto it_index = buckets.index.find(address);
+
+    if (it_index != buckets.index.end()) {
+        bucket& existing = it_index->second->second;
+
+        /* Refill the bucket according to the time since the last access. */
+        std::chrono::duration<double> elapsed = now - existing.last;
+
+        existing.tokens = std::min(burst, existing.tokens + elapsed.count() * rate);
+        existing.last = now;
+
+        /* The bucket is the most recently used one now. */
+        buckets.entries.splice(buckets.entries.begin(), buckets.entries, it_index->second);
+
+        return &existing;
+    }
+
+    if (!create) {
+        return nullptr;
+    }
+
+    /**
+     * Forget the least recently used sources if their buckets are full again.
+     * Such a bucket is identical to a new one, so no information gets lost.
+     * If the table is still too big the oldest source is forgotten anyway.
+     * Every bucket is removed at most once, so the cost is constant on average.
+     */
+    while (!buckets.entries.empty()) {
+        const auto& oldest = buckets.entries.back();
+        std::chrono::duration<double> elapsed = now - oldest.second.last;
+
+        if ((buckets.index.size() < MAX_BUCKETS)
+         && ((oldest.second.tokens + elapsed.count() * rate) < burst)) {
+            break;
+        }
+
+        buckets.index.erase(oldest.first);
+        buckets.entries.pop_back();
+    }
+
+    buckets.entries.emplace_front(address, bucket{burst, now});
+    buckets.index.emplace(address, buckets.entries.begin());
+
+    return &buckets.entries.front().second;
+}
+
+swd::analysis_slot::analysis_slot(swd::admission_ptr admission) :
+ admission_(std::move(admission)),
+ granted_(admission_->add_analysis()) {
+}
+
+swd::analysis_slot::~analysis_slot() {
+    if (granted_) {
+        admission_->remove_analysis();
+    }
+}
+
+bool swd::analysis_slot::is_granted() const {
+    return granted_;
+}
@@ -0,0 +1,103 @@
+/**
+ * Shadow Daemon -- Web Application Firewall
+ *
+ *   Copyright (C) 2014-2022 Hendrik Buchwald <hb@zecure.org>
+ *
+ * This file is part of Shadow Daemon. Shadow Daemon is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, version 2.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#include <boost/bind.hpp>
+
+#include "analysis_pool.h"
+
+swd::analysis_pool::analysis_pool() :
+ work_(std::make_unique<boost::asio::io_service::work>(io_service_)) {
+}
+
+void swd::analysis_pool::start(std::size_t thread_pool_size) {
+    using signature_type = std::size_t (boost::asio::io_service::*)();
+    signature_type run_ptr = &boost::asio::io_service::run;
+
+    for (std::size_t i = 0; i < thread_pool_size; ++i) {
+        threads_.create_thread(
+            boost::bind(run_ptr, &io_service_)
+        );
+    }
+}
+
+void swd::analysis_pool::stop() {
+    work_.reset();
+    io_service_.stop();
+    threads_.join_all();
+}
+
+void swd::analysis_pool::post(const std::function<void()>& task) {
+    ++queued_;
+
+    io_service_.post(
+        boost::bind(
+            &swd::analysis_pool::run,
+            this,
+            task,
+            std::chrono::steady_clock::now()
+        )
+    );
+}
+
+int swd::analysis_pool::get_queued() const {
+    return queued_;
+}
+
+int swd::analysis_pool::get_active() const {
+    return active_;
+}
+
+unsigned long long swd::analysis_pool::get_completed() const {
+    return completed_;
+}
+
+unsigned long long swd::analysis_pool::get_max_wait() const {
+    return max_wait_;
+}
+
+void swd::analysis_pool::run(const std::function<void()>& task,
+ std::chrono::steady_clock::time_point queued) {
+    --queued_;
+    ++active_;
+
+    unsigned long long wait = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - queued
+    ).count();
+
+    unsigned long long max_wait = max_wait_;
+
+    while ((wait > max_wait) && !max_wait_.compare_exchange_weak(max_wait, wait));
+
+    task();
+
+    --active_;
+    ++completed_;
+}
@@ -29,46 +29,424 @@
  * files in the program, then also delete it here.
  */
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iterator>
+#include <string>
 #include <utility>
 
 #include "blacklist.h"
 #include "blacklist_rule.h"
 #include "log.h"
+#include "safe_chars.h"
+#include "case_fold.h"
 
-swd::blacklist::blacklist(swd::cache_ptr cache) :
- cache_(std::move(cache)) {
+/* The max length of paths and values whose results are remembered. */
+#define MAX_MEMO_LENGTH 128
+
+namespace {
+    inline unsigned long long get_nanoseconds(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start
+        ).count();
+    }
+}
+
+swd::blacklist::blacklist(swd::cache_ptr cache, bool full_scan,
+ swd::scan_pool_ptr scan_pool, int scan_window, int unbounded_span) :
+ cache_(std::move(cache)),
+ full_scan_(full_scan),
+ scan_pool_(std::move(scan_pool)),
+ scan_window_(scan_window > 0 ? scan_window : 0),
+ unbounded_span_(unbounded_span > 0 ? unbounded_span : 0) {
 }
 
 void swd::blacklist::scan(const swd::request_ptr& request) const {
-    swd::blacklist_filters filters = cache_->get_blacklist_filters();
-    swd::parameters parameters = request->get_parameters();
+    swd::blacklist_filter_set_ptr filter_set = cache_->get_blacklist_filter_set(
+     request->get_profile()->get_disabled_tags());
+    const swd::parameters& parameters = request->get_parameters();
+
+    /**
+     * In active mode the verdict can not change anymore once the threshold is
+     * exceeded, so the remaining filters can be skipped. Learning and passive
+     * mode record all matching filters.
+     */
+    static const std::vector<unsigned int> no_order;
+    swd::filter_order_ptr sorted;
+
+    if (!full_scan_ && (request->get_profile()->get_mode() == MODE_ACTIVE)) {
+        sorted = filter_set->get_order();
+    }
+
+    const std::vector<unsigned int>& order = (sorted ? *sorted : no_order);
+
+    /* Large requests are split between threads, every parameter is scanned on its own. */
+    if (scan_pool_ && scan_pool_->should_split(parameters)) {
+        /* A single parameter can only be split by its filters. */
+        if (parameters.size() == 1) {
+            this->scan_filters(request, filter_set, order, parameters[0]);
+            return;
+        }
+
+        scan_pool_->run(parameters.size(), [&](std::size_t i) {
+            swd::blacklist::scan_buffers buffers;
+            this->scan_parameter(request, filter_set, order, parameters[i], buffers);
+        });
+
+        return;
+    }
+
+    /* Small requests are scanned together with the requests of other connections. */
+    if (cache_->get_scan_batcher()->is_enabled()) {
+        this->scan_batched(request, filter_set, order);
+        return;
+    }
+
+    /* The buffers are reused for all parameters. */
+    swd::blacklist::scan_buffers buffers;
 
-    /* Iterate over all parameters and check every filter. */
     for (const auto& parameter: parameters) {
-        for (const auto& filter: filters) {
-            /* If there is catastrophic backtracking boost throws an exception. */
-            try {
-                /* Add pointers to all filters that match to the parameter. */
-                if (filter->matches(parameter->get_value()) || filter->matches(parameter->get_path())) {
-                    parameter->add_blacklist_filter(filter);
-                }
-            } catch (...) {
-                swd::log::i()->send(swd::uncritical_error, "Unexpected blacklist problem");
-
-                /* Add the filter anyway to avoid a potential bypass. */
-                parameter->add_blacklist_filter(filter);
-            }
+        this->scan_parameter(request, filter_set, order, parameter, buffers);
+    }
+}
+
+void swd::blacklist::scan_parameter(const swd::request_ptr& request,
+ const swd::blacklist_filter_set_ptr& filter_set, const std::vector<unsigned int>& order,
+ const swd::parameter_ptr& parameter, swd::blacklist::scan_buffers& buffers) const {
+    int threshold = this->get_threshold(request, parameter);
+
+    if (!order.empty() && (threshold > -1)) {
+        this->match_until(filter_set, order, parameter, threshold, buffers.folded_value,
+         buffers.folded_path, buffers.value_matches, buffers.path_matches, buffers.matches);
+    } else {
+        this->match(filter_set, parameter->get_value(), buffers.folded_value, buffers.value_matches);
+        this->match(filter_set, parameter->get_path(), buffers.folded_path, buffers.path_matches);
+
+        /* Add pointers to all filters that match to the value or the path. */
+        buffers.matches.clear();
+        std::set_union(buffers.value_matches.begin(), buffers.value_matches.end(),
+         buffers.path_matches.begin(), buffers.path_matches.end(),
+         std::back_inserter(buffers.matches));
+    }
+
+    this->add_matches(filter_set, parameter, threshold, buffers.matches);
+}
+
+void swd::blacklist::scan_filters(const swd::request_ptr& request,
+ const swd::blacklist_filter_set_ptr& filter_set, const std::vector<unsigned int>& order,
+ const swd::parameter_ptr& parameter) const {
+    int threshold = this->get_threshold(request, parameter);
+    const std::string& value = parameter->get_value();
+    const std::string& path = parameter->get_path();
+
+    bool value_safe = swd::safe_chars::contains_only(value.data(), value.data() + value.length());
+    bool path_safe = swd::safe_chars::contains_only(path.data(), path.data() + path.length());
+
+    std::string folded_value;
+    std::string folded_path;
+    swd::case_fold::fold(value, folded_value);
+    swd::case_fold::fold(path, folded_path);
+
+    const swd::blacklist_filters& filters = filter_set->get_filters();
+    bool until = (!order.empty() && (threshold > -1));
+
+    /**
+     * Every filter writes only its own flag. The impact is shared, so that
+     * the remaining filters are skipped as soon as the verdict is final. The
+     * value is too long to be remembered, so skipped filters do not matter.
+     */
+    std::vector<char> hits(filters.size(), 0);
+    std::atomic<unsigned int> impact(0);
+
+    scan_pool_->run(filters.size(), [&](std::size_t k) {
+        unsigned int i = (until ? order[k] : k);
+        const swd::blacklist_filter_ptr& filter = filters[i];
+        bool complete = true;
+
+        if (until && (impact > (unsigned int) threshold)) {
+            return;
+        }
+
+        if ((!(value_safe && filter->needs_special()) && this->evaluate(filter, value, folded_value, complete))
+         || (!(path_safe && filter->needs_special()) && this->evaluate(filter, path, folded_path, complete))) {
+            hits[i] = 1;
+            impact += filter->get_impact();
+        }
+    });
+
+    std::vector<unsigned int> matches;
+
+    for (unsigned int i = 0; i < filters.size(); i++) {
+        if (hits[i]) {
+            matches.push_back(i);
         }
     }
 
-    /* Iterate over all parameters again and check if the total impact is higher than the threshold. */
+    this->add_matches(filter_set, parameter, threshold, matches);
+}
+
+void swd::blacklist::scan_batched(const swd::request_ptr& request,
+ const swd::blacklist_filter_set_ptr& filter_set, const std::vector<unsigned int>& order) const {
+    const swd::parameters& parameters = request->get_parameters();
+    swd::scan_memo_ptr scan_memo = cache_->get_scan_memo();
+    unsigned long long generation = filter_set->get_generation();
+
+    std::vector<int> parameter_thresholds;
+
     for (const auto& parameter: parameters) {
-        int threshold = this->get_threshold(request, parameter);
-        if ((threshold > -1) && (parameter->get_impact() > threshold)) {
-            parameter->set_threat(true);
-            parameter->set_critical_blacklist_impact(true);
+        parameter_thresholds.push_back(this->get_threshold(request, parameter));
+    }
+
+    /* Every parameter has two results, one for the value and one for the path. */
+    std::vector<std::vector<unsigned int>> results(parameters.size() * 2);
+    std::vector<const std::string*> inputs;
+    std::vector<int> thresholds;
+    std::vector<std::size_t> slots;
+
+    for (std::size_t i = 0; i < results.size(); i++) {
+        const std::string& input = ((i % 2) ? parameters[i / 2]->get_path()
+         : parameters[i / 2]->get_value());
+
+        /* Known results and safe strings without safe filters do not need a scan. */
+        bool safe = swd::safe_chars::contains_only(input.data(), input.data() + input.length());
+
+        if (safe && filter_set->get_safe_filters().empty()) {
+            continue;
         }
+
+        if ((input.length() <= MAX_MEMO_LENGTH) && scan_memo->find(generation, input, results[i])) {
+            continue;
+        }
+
+        /**
+         * The impact of the value or the path alone is enough to exceed the
+         * threshold of the parameter, so they can stop early on their own.
+         */
+        inputs.push_back(&input);
+        thresholds.push_back(order.empty() ? -1 : parameter_thresholds[i / 2]);
+        slots.push_back(i);
+    }
+
+    if (!inputs.empty()) {
+        std::vector<std::vector<unsigned int>> matches;
+        std::vector<bool> complete;
+
+        cache_->get_scan_batcher()->match(filter_set, inputs, thresholds, [this](
+         const swd::blacklist_filter_ptr& filter, const std::string& input,
+         const std::string& folded, bool& evaluated) {
+            return this->evaluate(filter, input, folded, evaluated);
+        }, matches, complete);
+
+        for (std::size_t j = 0; j < inputs.size(); j++) {
+            if (complete[j] && (inputs[j]->length() <= MAX_MEMO_LENGTH)) {
+                scan_memo->add(generation, *inputs[j], matches[j]);
+            }
+
+            results[slots[j]] = std::move(matches[j]);
+        }
+    }
+
+    std::vector<unsigned int> matches;
+
+    for (std::size_t i = 0; i < parameters.size(); i++) {
+        /* Add pointers to all filters that match to the value or the path. */
+        matches.clear();
+        std::set_union(results[i * 2].begin(), results[i * 2].end(),
+         results[i * 2 + 1].begin(), results[i * 2 + 1].end(), std::back_inserter(matches));
+
+        this->add_matches(filter_set, parameters[i], parameter_thresholds[i], matches);
+    }
+}
+
+void swd::blacklist::add_matches(const swd::blacklist_filter_set_ptr& filter_set,
+ const swd::parameter_ptr& parameter, int threshold, const std::vector<unsigned int>& matches) const {
+    const swd::blacklist_filters& filters = filter_set->get_filters();
+
+    for (unsigned int index: matches) {
+        parameter->add_blacklist_filter(filters[index]);
     }
+
+    /* Check if the total impact is higher than the threshold. */
+    if ((threshold > -1) && (parameter->get_impact() > (unsigned int) threshold)) {
+        parameter->set_threat(true);
+        parameter->set_critical_blacklist_impact(true);
+    }
+}
+
+void swd::blacklist::match(const swd::blacklist_filter_set_ptr& filter_set,
+ const std::string& input, std::string& folded, std::vector<unsigned int>& matches) const {
+    matches.clear();
+
+    /* Strings of safe characters can only match a few filters, often none at all. */
+    bool safe = swd::safe_chars::contains_only(input.data(), input.data() + input.length());
+
+    if (safe && filter_set->get_safe_filters().empty()) {
+        return;
+    }
+
+    /* Only short strings are remembered, long values are rarely repeated. */
+    bool memoizable = (input.length() <= MAX_MEMO_LENGTH);
+    swd::scan_memo_ptr scan_memo = cache_->get_scan_memo();
+
+    if (memoizable && scan_memo->find(filter_set->get_generation(), input, matches)) {
+        return;
+    }
+
+    const swd::blacklist_filters& filters = filter_set->get_filters();
+
+    /* The input is folded only once for all filters. */
+    swd::case_fold::fold(input, folded);
+
+    /* Results without the skipped quarantined filters are not remembered. */
+    bool complete = true;
+
+    if (safe) {
+        for (unsigned int i: filter_set->get_safe_filters()) {
+            if (this->evaluate(filters[i], input, folded, complete)) {
+                matches.push_back(i);
+            }
+        }
+    } else {
+        for (unsigned int i = 0; i < filters.size(); i++) {
+            if (this->evaluate(filters[i], input, folded, complete)) {
+                matches.push_back(i);
+            }
+        }
+    }
+
+    if (memoizable && complete) {
+        scan_memo->add(filter_set->get_generation(), input, matches);
+    }
+}
+
+void swd::blacklist::match_until(const swd::blacklist_filter_set_ptr& filter_set,
+ const std::vector<unsigned int>& order, const swd::parameter_ptr& parameter,
+ int threshold, std::string& folded_value, std::string& folded_path,
+ std::vector<unsigned int>& value_matches, std::vector<unsigned int>& path_matches,
+ std::vector<unsigned int>& matches) const {
+    const std::string& value = parameter->get_value();
+    const std::string& path = parameter->get_path();
+
+    matches.clear();
+    value_matches.clear();
+    path_matches.clear();
+
+    /* Remembered results are complete, so they are used as they are. */
+    swd::scan_memo_ptr scan_memo = cache_->get_scan_memo();
+    unsigned long long generation = filter_set->get_generation();
+
+    bool value_known = (value.length() <= MAX_MEMO_LENGTH)
+     && scan_memo->find(generation, value, value_matches);
+    bool path_known = (path.length() <= MAX_MEMO_LENGTH)
+     && scan_memo->find(generation, path, path_matches);
+
+    if (value_known && path_known) {
+        std::set_union(value_matches.begin(), value_matches.end(),
+         path_matches.begin(), path_matches.end(), std::back_inserter(matches));
+        return;
+    }
+
+    bool value_safe = swd::safe_chars::contains_only(value.data(), value.data() + value.length());
+    bool path_safe = swd::safe_chars::contains_only(path.data(), path.data() + path.length());
+
+    if (!value_known) {
+        swd::case_fold::fold(value, folded_value);
+    }
+
+    if (!path_known) {
+        swd::case_fold::fold(path, folded_path);
+    }
+
+    const swd::blacklist_filters& filters = filter_set->get_filters();
+    bool complete = true;
+    unsigned int impact = 0;
+
+    for (unsigned int i: order) {
+        const swd::blacklist_filter_ptr& filter = filters[i];
+        bool match = false;
+
+        /**
+         * The value and the path are both tested even if one of them matches
+         * already, so that the results can be remembered if the threshold is
+         * never exceeded.
+         */
+        if (value_known) {
+            match = std::binary_search(value_matches.begin(), value_matches.end(), i);
+        } else if (!(value_safe && filter->needs_special())
+         && this->evaluate(filter, value, folded_value, complete)) {
+            value_matches.push_back(i);
+            match = true;
+        }
+
+        if (path_known) {
+            match = match || std::binary_search(path_matches.begin(), path_matches.end(), i);
+        } else if (!(path_safe && filter->needs_special())
+         && this->evaluate(filter, path, folded_path, complete)) {
+            path_matches.push_back(i);
+            match = true;
+        }
+
+        if (!match) {
+            continue;
+        }
+
+        matches.push_back(i);
+        impact += filter->get_impact();
+
+        /* The verdict is final, the other filters do not matter anymore. */
+        if (impact > (unsigned int) threshold) {
+            complete = false;
+            break;
+        }
+    }
+
+    std::sort(matches.begin(), matches.end());
+
+    if (!complete) {
+        return;
+    }
+
+    if (!value_known && (value.length() <= MAX_MEMO_LENGTH)) {
+        std::sort(value_matches.begin(), value_matches.end());
+        scan_memo->add(generation, value, value_matches);
+    }
+
+    if (!path_known && (path.length() <= MAX_MEMO_LENGTH)) {
+        std::sort(path_matches.begin(), path_matches.end());
+        scan_memo->add(generation, path, path_matches);
+    }
+}
+
+bool swd::blacklist::evaluate(const swd::blacklist_filter_ptr& filter,
+ const std::string& input, const std::string& folded, bool& complete) const {
+    swd::filter_stats& stats = filter->get_stats();
+
+    if (cache_->get_filter_quarantine()->skip(stats)) {
+        complete = false;
+        return false;
+    }
+
+    bool match;
+    auto start = std::chrono::steady_clock::now();
+
+    /* If there is catastrophic backtracking boost throws an exception. */
+    try {
+        match = filter->matches(input, folded, scan_window_, unbounded_span_);
+        stats.add_evaluation(get_nanoseconds(start), match);
+    } catch (...) {
+        stats.add_abort(get_nanoseconds(start));
+
+        swd::log::i()->send(swd::uncritical_error, "Unexpected blacklist problem in filter "
+         + std::to_string(filter->get_id()));
+
+        /* Add the filter anyway to avoid a potential bypass. */
+        match = true;
+    }
+
+    cache_->get_filter_quarantine()->check(filter->get_id(), stats);
+
+    return match;
 }
 
 int swd::blacklist::get_threshold(const swd::request_ptr& request, const swd::parameter_ptr& parameter) const {
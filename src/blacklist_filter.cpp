@@ -29,7 +29,12 @@
  * files in the program, then also delete it here.
  */
 
+#include <algorithm>
+
 #include "blacklist_filter.h"
+#include "case_fold.h"
+#include "match_span.h"
+#include "safe_chars.h"
 
 void swd::blacklist_filter::set_id(const unsigned long long& id) {
     id_ = id;
@@ -48,9 +53,93 @@ unsigned int swd::blacklist_filter::get_impact() const {
 }
 
 void swd::blacklist_filter::set_regex(const std::string& regex) {
-    regex_.set_expression(regex, boost::regex::icase | boost::regex::mod_s);
+    /* Folded expressions match folded input without the cost of icase. */
+    std::string folded_regex;
+    folded_ = swd::case_fold::fold_regex(regex, folded_regex);
+
+    if (folded_) {
+        engine_ = swd::regex_engine::compile(folded_regex, false);
+    } else {
+        engine_ = swd::regex_engine::compile(regex, true);
+    }
+
+    regex_ = regex;
+
+    /* The characters a match needs are derived once when the filter is loaded. */
+    needs_special_ = !swd::safe_chars::can_match(regex);
+    max_span_ = swd::match_span::get_max_length(regex);
+}
+
+const std::string& swd::blacklist_filter::get_regex() const {
+    return regex_;
 }
 
 bool swd::blacklist_filter::matches(const std::string& input) const {
-    return regex_search(input, regex_);
+    if (!folded_) {
+        return engine_->search(input);
+    }
+
+    std::string folded;
+    swd::case_fold::fold(input, folded);
+
+    return engine_->search(folded);
+}
+
+bool swd::blacklist_filter::matches(const std::string& input, const std::string& folded) const {
+    return engine_->search(folded_ ? folded : input);
+}
+
+bool swd::blacklist_filter::matches(const std::string& input, const std::string& folded,
+ std::size_t window, std::size_t unbounded_span) const {
+    const std::string& subject = (folded_ ? folded : input);
+
+    /* A match of a filter without an upper bound might not fit into any window. */
+    if ((window == 0) || ((max_span_ == swd::match_span::UNBOUNDED) && (unbounded_span == 0))) {
+        return engine_->search(subject);
+    }
+
+    std::size_t overlap = ((max_span_ == swd::match_span::UNBOUNDED) ? unbounded_span : max_span_);
+
+    if (subject.length() <= window + overlap) {
+        return engine_->search(subject);
+    }
+
+    for (std::size_t begin = 0; begin < subject.length(); begin += window) {
+        std::size_t end = std::min(begin + window + overlap, subject.length());
+
+        if (end == subject.length()) {
+            return engine_->search(subject, begin, end);
+        }
+
+        /**
+         * Anchors, word boundaries and lookaheads at the end of a window do
+         * not see the characters behind it, so a hit is confirmed with the
+         * rest of the input. This happens at most once per input.
+         */
+        if (engine_->search(subject, begin, end)) {
+            return engine_->search(subject, begin, subject.length());
+        }
+    }
+
+    return false;
+}
+
+long swd::blacklist_filter::get_max_span() const {
+    return max_span_;
+}
+
+bool swd::blacklist_filter::needs_special() const {
+    return needs_special_;
+}
+
+void swd::blacklist_filter::add_tag(const unsigned long long& tag_id) {
+    tags_.insert(tag_id);
+}
+
+const std::set<unsigned long long>& swd::blacklist_filter::get_tags() const {
+    return tags_;
+}
+
+swd::filter_stats& swd::blacklist_filter::get_stats() {
+    return stats_;
 }
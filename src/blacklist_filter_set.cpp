@@ -0,0 +1,121 @@
+/**
+ * Shadow Daemon -- Web Application Firewall
+ *
+ *   Copyright (C) 2014-2022 Hendrik Buchwald <hb@zecure.org>
+ *
+ * This file is part of Shadow Daemon. Shadow Daemon is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, version 2.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <tuple>
+#include <utility>
+#include <boost/make_shared.hpp>
+
+#include "blacklist_filter_set.h"
+
+namespace {
+    /**
+     * The generations are unique for the whole process, so that two sets are
+     * never mistaken for each other.
+     */
+    std::atomic<unsigned long long> next_generation(1);
+}
+
+/* The number of nanoseconds between two sorts of the order. */
+#define ORDER_INTERVAL 1000000000LL
+
+swd::blacklist_filter_set::blacklist_filter_set(swd::blacklist_filters filters) :
+ filters_(std::move(filters)),
+ generation_(next_generation++),
+ order_time_(0) {
+    for (unsigned int i = 0; i < filters_.size(); i++) {
+        if (!filters_[i]->needs_special()) {
+            safe_filters_.push_back(i);
+        }
+    }
+}
+
+const swd::blacklist_filters& swd::blacklist_filter_set::get_filters() const {
+    return filters_;
+}
+
+unsigned long long swd::blacklist_filter_set::get_generation() const {
+    return generation_;
+}
+
+const std::vector<unsigned int>& swd::blacklist_filter_set::get_safe_filters() const {
+    return safe_filters_;
+}
+
+swd::filter_order_ptr swd::blacklist_filter_set::get_order() const {
+    long long now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()
+    ).count();
+
+    long long last = order_time_.load(std::memory_order_relaxed);
+    swd::filter_order_ptr order = boost::atomic_load(&order_);
+
+    /* Only one request sorts again, the others keep using the old order. */
+    if (order && ((now - last) < ORDER_INTERVAL)) {
+        return order;
+    }
+
+    if (!order_time_.compare_exchange_strong(last, now) && order) {
+        return order;
+    }
+
+    /**
+     * The score is the impact per microsecond of the average evaluation, so
+     * cheap filters with high impacts are evaluated first. Quarantined filters
+     * come last. The statistics keep changing, so a snapshot is sorted.
+     */
+    std::vector<std::tuple<bool, double, unsigned int>> scores;
+    scores.reserve(filters_.size());
+
+    for (unsigned int i = 0; i < filters_.size(); i++) {
+        swd::filter_stats& stats = filters_[i]->get_stats();
+        double score = filters_[i]->get_impact()
+         / ((stats.get_average_nanoseconds() / 1000.0) + 1.0);
+
+        scores.emplace_back(stats.is_quarantined(), -score, i);
+    }
+
+    std::sort(scores.begin(), scores.end());
+
+    auto sorted = boost::make_shared<std::vector<unsigned int>>();
+    sorted->reserve(scores.size());
+
+    for (const auto& score: scores) {
+        sorted->push_back(std::get<2>(score));
+    }
+
+    order = sorted;
+    boost::atomic_store(&order_, order);
+
+    return order;
+}
@@ -29,47 +29,45 @@
  * files in the program, then also delete it here.
  */
 
-#ifndef CONNECTION_EXCEPTION_H
-#define CONNECTION_EXCEPTION_H
+#include <boost/make_shared.hpp>
 
-#include <string>
+#include "buffer_pool.h"
 
-namespace swd::exceptions {
-    /**
-     * @brief Critical exception in one of the core components.
-     */
-    class connection_exception : public std::exception {
-        public:
-            /**
-             * @brief Constructs an exception.
-             */
-            connection_exception(int code, std::string message);
+swd::buffer_pool::buffer_pool(std::size_t max_idle) :
+ max_idle_(max_idle) {
+}
 
-            /**
-             * @brief Return the exception code.
-             *
-             * @return The exception code
-             */
-            int get_code() const;
+swd::buffer_ptr swd::buffer_pool::acquire() {
+    {
+        boost::unique_lock scoped_lock(mutex_);
 
-            /**
-             * @brief Return the exception message.
-             *
-             * @return The exception message
-             */
-            std::string get_message() const;
+        if (!buffers_.empty()) {
+            swd::buffer_ptr buffer = buffers_.back();
+            buffers_.pop_back();
 
-        private:
-            /**
-             * @brief Information about the exception.
-             */
-            int code_;
+            return buffer;
+        }
+    }
 
-            /**
-             * @brief Information about the exception.
-             */
-            std::string message_;
-    };
+    /* Allocate outside of the mutex, the pool is empty anyway. */
+    return boost::make_shared<swd::buffer>();
 }
 
-#endif /* CONNECTION_EXCEPTION_H */
+void swd::buffer_pool::release(const swd::buffer_ptr& buffer) {
+    if (!buffer) {
+        return;
+    }
+
+    boost::unique_lock scoped_lock(mutex_);
+
+    /* Free the buffer if there are already enough spare ones. */
+    if (buffers_.size() < max_idle_) {
+        buffers_.push_back(buffer);
+    }
+}
+
+std::size_t swd::buffer_pool::get_idle() const {
+    boost::unique_lock scoped_lock(mutex_);
+
+    return buffers_.size();
+}
@@ -30,14 +30,22 @@
  */
 
 #include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/make_shared.hpp>
+#include <chrono>
 #include <utility>
 
 #include "cache.h"
 #include "log.h"
 #include "database_exception.h"
 
+/* The min number of nanoseconds between two reloads of the profile ids. */
+#define PROFILE_IDS_INTERVAL 1000000000LL
+
 swd::cache::cache(swd::database_ptr database) :
- database_(std::move(database)) {
+ database_(std::move(database)),
+ scan_memo_(boost::make_shared<swd::scan_memo>()),
+ filter_quarantine_(boost::make_shared<swd::filter_quarantine>()),
+ scan_batcher_(boost::make_shared<swd::scan_batcher>()) {
 }
 
 void swd::cache::start() {
@@ -177,6 +185,11 @@ void swd::cache::reset_profile(unsigned long long profile_id) {
         boost::unique_lock scoped_lock(integrity_rules_mutex_);
         integrity_rules_[profile_id].clear();
     }
+
+    {
+        boost::unique_lock scoped_lock(hmacs_mutex_);
+        hmacs_.erase(profile_id);
+    }
 }
 
 void swd::cache::reset_all() {
@@ -190,7 +203,8 @@ void swd::cache::reset_all() {
 
     {
         boost::unique_lock scoped_lock(blacklist_filters_mutex_);
-        blacklist_filters_.clear();
+        blacklist_filter_set_.reset();
+        blacklist_filter_subsets_.clear();
     }
 
     {
@@ -207,25 +221,95 @@ void swd::cache::reset_all() {
         boost::unique_lock scoped_lock(integrity_rules_mutex_);
         integrity_rules_.clear();
     }
+
+    {
+        boost::unique_lock scoped_lock(hmacs_mutex_);
+        hmacs_.clear();
+    }
+
+    boost::atomic_store(&profile_ids_, boost::shared_ptr<const std::set<unsigned long long>>());
+    profile_ids_loaded_ = 0;
 }
 
 void swd::cache::set_blacklist_filters(const swd::blacklist_filters&
  blacklist_filters) {
     boost::unique_lock scoped_lock(blacklist_filters_mutex_);
 
-    blacklist_filters_ = blacklist_filters;
+    blacklist_filter_set_ = boost::make_shared<const swd::blacklist_filter_set>(
+        blacklist_filters
+    );
+
+    blacklist_filter_subsets_.clear();
 }
 
 swd::blacklist_filters swd::cache::get_blacklist_filters() {
+    return get_blacklist_filter_set()->get_filters();
+}
+
+swd::blacklist_filter_set_ptr swd::cache::get_blacklist_filter_set() {
+    return get_blacklist_filter_set(std::set<unsigned long long>());
+}
+
+swd::blacklist_filter_set_ptr swd::cache::get_blacklist_filter_set(
+ const std::set<unsigned long long>& disabled_tags) {
     boost::unique_lock scoped_lock(blacklist_filters_mutex_);
 
-    if (!blacklist_filters_.empty()) {
-        return blacklist_filters_;
+    if (!blacklist_filter_set_) {
+        /* A new set gets a new generation, so old scan results are not used anymore. */
+        blacklist_filter_set_ = boost::make_shared<const swd::blacklist_filter_set>(
+            database_->get_blacklist_filters()
+        );
+
+        blacklist_filter_subsets_.clear();
+    }
+
+    if (disabled_tags.empty()) {
+        return blacklist_filter_set_;
     }
 
-    blacklist_filters_ = database_->get_blacklist_filters();
+    swd::blacklist_filter_set_ptr& subset = blacklist_filter_subsets_[disabled_tags];
 
-    return blacklist_filters_;
+    if (subset) {
+        return subset;
+    }
+
+    /* The subset shares the compiled filters and their statistics with the full set. */
+    swd::blacklist_filters filters;
+
+    for (const auto& filter: blacklist_filter_set_->get_filters()) {
+        bool disabled = false;
+
+        for (const auto& tag_id: filter->get_tags()) {
+            if (disabled_tags.find(tag_id) != disabled_tags.end()) {
+                disabled = true;
+                break;
+            }
+        }
+
+        if (!disabled) {
+            filters.push_back(filter);
+        }
+    }
+
+    swd::log::i()->send(swd::notice, "Using " + std::to_string(filters.size()) + " of "
+     + std::to_string(blacklist_filter_set_->get_filters().size()) + " blacklist filters"
+     " for " + std::to_string(disabled_tags.size()) + " disabled tags");
+
+    subset = boost::make_shared<const swd::blacklist_filter_set>(filters);
+
+    return subset;
+}
+
+swd::scan_memo_ptr swd::cache::get_scan_memo() {
+    return scan_memo_;
+}
+
+swd::filter_quarantine_ptr swd::cache::get_filter_quarantine() {
+    return filter_quarantine_;
+}
+
+swd::scan_batcher_ptr swd::cache::get_scan_batcher() {
+    return scan_batcher_;
 }
 
 void swd::cache::add_blacklist_rules(const unsigned long long& profile_id,
@@ -326,3 +410,80 @@ swd::integrity_rules swd::cache::get_integrity_rules(const unsigned long long& p
 
     return integrity_rules;
 }
+
+swd::hmac_ptr swd::cache::get_hmac(const unsigned long long& profile_id,
+ const std::string& key) {
+    boost::unique_lock scoped_lock(hmacs_mutex_);
+
+    auto it_hmac = hmacs_.find(profile_id);
+
+    if ((it_hmac != hmacs_.end()) && (it_hmac->second.first == key)) {
+        return it_hmac->second.second;
+    }
+
+    swd::hmac_ptr hmac = boost::make_shared<const swd::hmac>(
+        (const byte *)key.data(),
+        key.size()
+    );
+
+    hmacs_[profile_id] = std::make_pair(key, hmac);
+
+    return hmac;
+}
+
+std::pair<std::string, swd::hmac_ptr> swd::cache::find_hmac(
+ const unsigned long long& profile_id) {
+    boost::unique_lock scoped_lock(hmacs_mutex_);
+
+    auto it_hmac = hmacs_.find(profile_id);
+
+    if (it_hmac == hmacs_.end()) {
+        return std::make_pair(std::string(), swd::hmac_ptr());
+    }
+
+    return it_hmac->second;
+}
+
+bool swd::cache::has_profile_id(const unsigned long long& profile_id) {
+    boost::shared_ptr<const std::set<unsigned long long>> profile_ids =
+     boost::atomic_load(&profile_ids_);
+
+    if (profile_ids && (profile_ids->find(profile_id) != profile_ids->end())) {
+        return true;
+    }
+
+    /**
+     * The profile might be new, but do not ask the database too often. Only
+     * one thread reloads the ids, the others do not wait for the database.
+     */
+    long long now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()
+    ).count();
+
+    long long loaded = profile_ids_loaded_.load();
+
+    if (((loaded != 0) && (now - loaded < PROFILE_IDS_INTERVAL)) ||
+     !profile_ids_loaded_.compare_exchange_strong(loaded, now)) {
+        /* Without any ids yet the normal profile query has to decide. */
+        return !profile_ids;
+    }
+
+    std::vector<unsigned long long> ids;
+
+    try {
+        ids = database_->get_profile_ids();
+    } catch (const swd::exceptions::database_exception& e) {
+        swd::log::i()->send(swd::uncritical_error, e.get_message());
+
+        /**
+         * The next reload is only tried after the interval, so that junk requests
+         * do not flood a struggling database. Until then the last ids answer.
+         */
+        return !profile_ids;
+    }
+
+    profile_ids = boost::make_shared<const std::set<unsigned long long>>(ids.begin(), ids.end());
+    boost::atomic_store(&profile_ids_, profile_ids);
+
+    return (profile_ids->find(profile_id) != profile_ids->end());
+}
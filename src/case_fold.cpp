@@ -0,0 +1,183 @@
+/**
+ * Shadow Daemon -- Web Application Firewall
+ *
+ *   Copyright (C) 2014-2022 Hendrik Buchwald <hb@zecure.org>
+ *
+ * This file is part of Shadow Daemon. Shadow Daemon is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, version 2.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#include <cstring>
+
+#include "case_fold.h"
+
+void swd::case_fold::fold(const std::string& input, std::string& output) {
+    output.resize(input.length());
+
+    const char* source = input.data();
+    char* target = &output[0];
+
+    for (std::size_t i = 0; i < input.length(); i++) {
+        unsigned char c = source[i];
+        target[i] = (char)(c + (((unsigned char)(c - 'A') < 26) << 5));
+    }
+}
+
+bool swd::case_fold::fold_regex(const std::string& regex, std::string& output) {
+    output.clear();
+    output.reserve(regex.length());
+
+    std::size_t pos = 0;
+
+    while (pos < regex.length()) {
+        char c = regex[pos++];
+
+        if (c == '\\') {
+            output += c;
+
+            if (!copy_escape(regex, pos, output)) {
+                return false;
+            }
+        } else if (c == '(') {
+            output += c;
+
+            /* Inline modifiers and named groups are not supported. */
+            if ((pos < regex.length()) && (regex[pos] == '?')) {
+                if ((pos + 1 < regex.length()) && strchr(":=!", regex[pos + 1])) {
+                    output.append(regex, pos, 2);
+                    pos += 2;
+                } else if ((pos + 2 < regex.length()) && (regex[pos + 1] == '<') &&
+                 strchr("=!", regex[pos + 2])) {
+                    output.append(regex, pos, 3);
+                    pos += 3;
+                } else {
+                    return false;
+                }
+            }
+        } else if (c == '[') {
+            output += c;
+
+            if ((pos < regex.length()) && (regex[pos] == '^')) {
+                output += regex[pos++];
+            }
+
+            /* A closing bracket at the beginning is a literal. */
+            bool first = true;
+
+            while (true) {
+                if (pos >= regex.length()) {
+                    return false;
+                }
+
+                char start = regex[pos++];
+
+                if ((start == ']') && !first) {
+                    output += start;
+                    break;
+                }
+
+                first = false;
+
+                if ((start == '[') && (pos < regex.length()) && (regex[pos] == ':')) {
+                    return false;
+                }
+
+                if (start == '\\') {
+                    output += start;
+
+                    if (!copy_escape(regex, pos, output)) {
+                        return false;
+                    }
+
+                    /* Escapes can not start a range that would have to be folded. */
+                    if ((pos + 1 < regex.length()) && (regex[pos] == '-') && (regex[pos + 1] != ']')) {
+                        return false;
+                    }
+
+                    continue;
+                }
+
+                if ((pos + 1 < regex.length()) && (regex[pos] == '-') && (regex[pos + 1] != ']')) {
+                    char end = regex[pos + 1];
+                    pos += 2;
+
+                    if (end == '\\') {
+                        return false;
+                    }
+
+                    bool upper = ((start >= 'A') && (end <= 'Z'));
+                    bool lower = ((start >= 'a') && (end <= 'z'));
+                    bool letters = ((start <= 'z') && (end >= 'A'));
+
+                    /* Ranges must either consist of letters of one case or of no letters at all. */
+                    if (letters && !upper && !lower) {
+                        bool between = ((start > 'Z') && (end < 'a'));
+
+                        if (!between) {
+                            return false;
+                        }
+                    }
+
+                    output += (upper ? (char)(start | 0x20) : start);
+                    output += '-';
+                    output += (upper ? (char)(end | 0x20) : end);
+                } else {
+                    output += (((start >= 'A') && (start <= 'Z')) ? (char)(start | 0x20) : start);
+                }
+            }
+        } else if ((c >= 'A') && (c <= 'Z')) {
+            output += (char)(c | 0x20);
+        } else {
+            output += c;
+        }
+    }
+
+    return true;
+}
+
+bool swd::case_fold::copy_escape(const std::string& regex, std::size_t& pos,
+ std::string& output) {
+    if (pos >= regex.length()) {
+        return false;
+    }
+
+    char c = regex[pos++];
+
+    /* Letters are only allowed for escapes that do not match specific letters. */
+    if (((c >= 'a') && (c <= 'z')) || ((c >= 'A') && (c <= 'Z'))) {
+        if (!strchr("bBdDwWsSntrfvAzZG", c)) {
+            return false;
+        }
+    }
+
+    /* Octal and multi-digit escapes can match specific letters as well. */
+    if ((c == '0') || ((c >= '1') && (c <= '9') && (pos < regex.length()) &&
+     (regex[pos] >= '0') && (regex[pos] <= '9'))) {
+        return false;
+    }
+
+    output += c;
+    return true;
+}
@@ -36,6 +36,7 @@
 #include "build_config.h"
 #include "core_exception.h"
 #include "config_exception.h"
+#include "regex_engine.h"
 
 swd::config::config() :
  od_generic_("Generic options"),
@@ -56,7 +57,29 @@ swd::config::config() :
         ("ssl-cert,C", po::value<std::string>(), "path to ssl cert")
         ("ssl-key,K", po::value<std::string>(), "path to ssl key")
         ("ssl-dh,H", po::value<std::string>(), "path to dhparam file")
-        ("threads,t", po::value<int>()->default_value(10), "sets the size of the threadpool");
+        ("ssl-session-cache", po::value<int>()->default_value(20480), "number of cached ssl sessions")
+        ("ssl-session-timeout", po::value<int>()->default_value(300), "seconds ssl sessions can be resumed")
+        ("threads,t", po::value<int>()->default_value(10), "sets the size of the io threadpool")
+        ("analysis-threads", po::value<int>()->default_value(10), "sets the size of the analysis threadpool")
+        ("scan-threads", po::value<int>()->default_value(4), "sets the size of the threadpool for large requests")
+        ("parallel-scan-size", po::value<int>()->default_value(65536), "min size of requests that are split between threads")
+        ("scan-memo-size", po::value<int>()->default_value(65536), "max number of remembered blacklist results")
+        ("batch-window", po::value<int>()->default_value(-1), "microseconds to collect strings of requests for a batch")
+        ("batch-size", po::value<int>()->default_value(64), "max number of strings in a batch")
+        ("regex-engine", po::value<std::string>()->default_value("boost"), "library for the filters (boost, re2 or pcre2)")
+        ("filter-cost-budget", po::value<int>()->default_value(-1), "max average nanoseconds of a blacklist filter")
+        ("filter-sample-rate", po::value<int>()->default_value(100), "inputs per evaluation of quarantined filters")
+        ("full-scan", "evaluate all blacklist filters in active mode")
+        ("scan-window-size", po::value<int>()->default_value(65536), "size of the windows long values are scanned in")
+        ("scan-unbounded-span", po::value<int>()->default_value(-1), "assumed match length of unbounded filters in windows")
+        ("timeout-handshake", po::value<int>()->default_value(10), "seconds to finish the ssl handshake")
+        ("timeout-idle", po::value<int>()->default_value(30), "seconds a connection may be idle")
+        ("timeout-request", po::value<int>()->default_value(60), "seconds to send a complete request")
+        ("max-connections", po::value<int>()->default_value(-1), "max number of concurrent connections")
+        ("max-analyses", po::value<int>()->default_value(-1), "max number of concurrent analyses")
+        ("rate-limit", po::value<int>()->default_value(-1), "requests per second per client")
+        ("rate-burst", po::value<int>()->default_value(100), "requests per client at once")
+        ("load-shedding", po::value<std::string>()->default_value("closed"), "reply to shed requests (open or closed)");
 
     od_daemon_.add_options()
         ("daemonize,D", "detach and become a daemon")
@@ -69,7 +92,9 @@ swd::config::config() :
     od_security_.add_options()
         ("max-parameters", po::value<int>()->default_value(64), "max number of parameters per request")
         ("max-length-path", po::value<int>()->default_value(64), "max length of parameter paths")
-        ("max-length-value", po::value<int>()->default_value(-1), "max length of parameter values");
+        ("max-length-value", po::value<int>()->default_value(-1), "max length of parameter values")
+        ("max-length-inflated", po::value<int>()->default_value(16777216), "max length of inflated request content")
+        ("max-failures", po::value<int>()->default_value(-1), "max number of failed requests per client and minute");
 
     od_database_.add_options()
         ("db-wait,W", "wait for database")
@@ -137,16 +162,40 @@ void swd::config::validate() const {
         throw swd::exceptions::config_exception("threadpool must be greater than zero");
     }
 
+    if (!this->defined("analysis-threads") || (this->get<int>("analysis-threads") < 1)) {
+        throw swd::exceptions::config_exception("analysis threadpool must be greater than zero");
+    }
+
+    if (!this->defined("scan-threads") || (this->get<int>("scan-threads") < 0)) {
+        throw swd::exceptions::config_exception("scan threadpool must not be negative");
+    }
+
     if (!this->defined("address") || !this->defined("port")) {
         throw swd::exceptions::config_exception("address and port required");
     }
 
     if (this->defined("ssl")) {
-        if (!this->defined("ssl-cert") || !this->defined("ssl-key") || !this->defined("ssl-dh")) {
+        if (!this->defined("ssl-cert") || !this->defined("ssl-key")) {
             throw swd::exceptions::config_exception("required ssl input missing");
         }
     }
 
+    if (this->defined("load-shedding")) {
+        std::string load_shedding = this->get<std::string>("load-shedding");
+
+        if ((load_shedding != "open") && (load_shedding != "closed")) {
+            throw swd::exceptions::config_exception("load-shedding must be open or closed");
+        }
+    }
+
+    if (this->defined("regex-engine")) {
+        std::string regex_engine = this->get<std::string>("regex-engine");
+
+        if (!swd::regex_engine::is_available(regex_engine)) {
+            throw swd::exceptions::config_exception("regex-engine " + regex_engine + " is not available");
+        }
+    }
+
     if (!this->defined("config")) {
         throw swd::exceptions::config_exception("config required");
     }
@@ -29,6 +29,7 @@
  * files in the program, then also delete it here.
  */
 
+#include <chrono>
 #include <utility>
 
 #include "connection.h"
@@ -38,39 +39,63 @@
 #include "config.h"
 #include "log.h"
 #include "database_exception.h"
-#include "connection_exception.h"
 
 swd::connection::connection(boost::asio::io_service& io_service,
  swd::context& context, bool ssl, swd::storage_ptr storage,
- swd::database_ptr database, swd::cache_ptr cache) :
+ swd::database_ptr database, swd::cache_ptr cache,
+ swd::buffer_pool_ptr buffer_pool, swd::admission_ptr admission,
+ swd::analysis_pool_ptr analysis_pool, swd::scan_pool_ptr scan_pool) :
  strand_(io_service),
- socket_(io_service),
- ssl_socket_(io_service, context),
+ timer_(io_service),
  ssl_(ssl),
  storage_(std::move(storage)),
  database_(std::move(database)),
- cache_(std::move(cache)) {
+ cache_(std::move(cache)),
+ buffer_pool_(std::move(buffer_pool)),
+ admission_(std::move(admission)),
+ analysis_pool_(std::move(analysis_pool)),
+ scan_pool_(std::move(scan_pool)) {
+    /**
+     * Only create the transport that is really used. The ssl stream is
+     * expensive, because OpenSSL allocates its state and bio buffers with it.
+     */
+    if (ssl_) {
+        ssl_socket_ = std::make_unique<swd::ssl_socket>(io_service, context);
+    } else {
+        socket_ = std::make_unique<swd::socket>(io_service);
+    }
 }
 
-swd::socket& swd::connection::socket() {
-    return socket_;
+swd::connection::~connection() {
+    if (registered_) {
+        admission_->remove_connection();
+    }
 }
 
-swd::ssl_socket::lowest_layer_type& swd::connection::ssl_socket() {
-    return ssl_socket_.lowest_layer();
+swd::socket& swd::connection::socket() {
+    if (ssl_) {
+        return ssl_socket_->next_layer();
+    }
+
+    return *socket_;
 }
 
 void swd::connection::start() {
     /* Save the ip of the httpd server in the request object. */
-    boost::asio::ip::tcp::endpoint remote_endpoint;
+    remote_address_ = socket().remote_endpoint().address();
 
-    if (ssl_) {
-        remote_endpoint = ssl_socket_.lowest_layer().remote_endpoint();
-    } else {
-        remote_endpoint = socket_.remote_endpoint();
-    }
+    /* Slow clients must not be able to occupy a connection forever. */
+    timeout_handshake_ = swd::config::i()->get<int>("timeout-handshake");
+    timeout_idle_ = swd::config::i()->get<int>("timeout-idle");
+    timeout_request_ = swd::config::i()->get<int>("timeout-request");
 
-    remote_address_ = remote_endpoint.address();
+    /**
+     * If the daemon is overloaded or the client sends too many requests the
+     * connection is still read, but answered right away without any analysis.
+     */
+    shed_ = !admission_->add_connection(remote_address_);
+    registered_ = true;
+    fail_open_ = (swd::config::i()->get<std::string>("load-shedding") == "open");
 
     if (ssl_) {
         swd::log::i()->send(swd::notice, "Starting new ssl connection with "
@@ -80,7 +105,9 @@ void swd::connection::start() {
          * If this is a SSL connection we have to do a handshake before we can
          * start reading.
          */
-        ssl_socket_.async_handshake(
+        set_deadline(timeout_handshake_);
+
+        ssl_socket_->async_handshake(
             boost::asio::ssl::stream_base::server,
             strand_.wrap(
                 boost::bind(
@@ -100,9 +127,27 @@ void swd::connection::start() {
 }
 
 void swd::connection::start_read() {
+    /* The time for the complete request starts with the first read. */
+    if (request_deadline_ == boost::asio::steady_timer::time_point()) {
+        if (timeout_request_ > 0) {
+            request_deadline_ = boost::asio::steady_timer::clock_type::now()
+             + std::chrono::seconds(timeout_request_);
+        } else {
+            request_deadline_ = boost::asio::steady_timer::time_point::max();
+        }
+    }
+
+    set_deadline(timeout_idle_);
+
     if (ssl_) {
-        ssl_socket_.async_read_some(
-            boost::asio::buffer(buffer_),
+        /**
+         * The ssl stream may already hold decrypted data that is not visible
+         * on the socket, so it is not possible to wait for readability first.
+         */
+        buffer_ = buffer_pool_->acquire();
+
+        ssl_socket_->async_read_some(
+            boost::asio::buffer(*buffer_),
             strand_.wrap(
                 boost::bind(
                     &connection::handle_read,
@@ -113,14 +158,17 @@ void swd::connection::start_read() {
             )
         );
     } else {
-        socket_.async_read_some(
-            boost::asio::buffer(buffer_),
+        /**
+         * Wait until there is data without holding a buffer. This way idle
+         * and slow connections do not occupy any buffer memory.
+         */
+        socket_->async_wait(
+            boost::asio::ip::tcp::socket::wait_read,
             strand_.wrap(
                 boost::bind(
-                    &connection::handle_read,
+                    &connection::handle_wait,
                     shared_from_this(),
-                    boost::asio::placeholders::error,
-                    boost::asio::placeholders::bytes_transferred
+                    boost::asio::placeholders::error
                 )
             )
         );
@@ -128,22 +176,50 @@ void swd::connection::start_read() {
 }
 
 void swd::connection::start_read(const boost::system::error_code& e) {
+    /* A pending deadline would keep the connection alive after the error. */
     if (e) {
+        cancel_deadline();
         return;
     }
 
     start_read();
 }
 
+void swd::connection::handle_wait(const boost::system::error_code& e) {
+    if (e) {
+        cancel_deadline();
+        return;
+    }
+
+    /* There is data available, so the read completes right away. */
+    buffer_ = buffer_pool_->acquire();
+
+    socket_->async_read_some(
+        boost::asio::buffer(*buffer_),
+        strand_.wrap(
+            boost::bind(
+                &connection::handle_read,
+                shared_from_this(),
+                boost::asio::placeholders::error,
+                boost::asio::placeholders::bytes_transferred
+            )
+        )
+    );
+}
+
 void swd::connection::handle_read(const boost::system::error_code& e,
  std::size_t bytes_transferred) {
     /**
-     * If an error occurs then no new asynchronous operations are started. This
-     * means that all shared_ptr references to the connection object will disappear
-     * and the object will be destroyed automatically after this handler returns.
-     * The connection class's destructor closes the socket.
+     * If an error occurs then no new asynchronous operations are started and the
+     * deadline is cancelled. This means that all shared_ptr references to the
+     * connection object will disappear and the object will be destroyed
+     * automatically after this handler returns. The connection class's
+     * destructor closes the socket.
      */
     if (e) {
+        cancel_deadline();
+        buffer_pool_->release(buffer_);
+        buffer_.reset();
         return;
     }
 
@@ -155,10 +231,30 @@ void swd::connection::handle_read(const boost::system::error_code& e,
     boost::tie(result, boost::tuples::ignore) =
         request_parser_.parse(
             request_,
-            buffer_.data(),
-            buffer_.data() + bytes_transferred
+            buffer_->data(),
+            buffer_->data() + bytes_transferred
         );
 
+    /* The parser copied the data into the request, so the buffer is not needed anymore. */
+    buffer_pool_->release(buffer_);
+    buffer_.reset();
+
+    /**
+     * Start hashing the content as soon as the profile id is known and its key
+     * is cached. This way the mac is ready when the last chunk arrives. The key
+     * is compared with the profile from the database later.
+     */
+    if (!hmac_checked_ && !shed_ && request_parser_.has_profile_id()) {
+        hmac_checked_ = true;
+
+        std::pair<std::string, swd::hmac_ptr> cached_hmac =
+         cache_->find_hmac(request_->get_profile_id());
+
+        if (cached_hmac.second) {
+            request_->start_hmac(*cached_hmac.second, cached_hmac.first);
+        }
+    }
+
     /**
      * If result is true the complete request is parsed. If it is false there was
      * an error. If it is indeterminate then the parsing is not complete yet and
@@ -172,150 +268,271 @@ void swd::connection::handle_read(const boost::system::error_code& e,
         return;
     }
 
+    /* The request is complete, the client is not responsible for the processing time. */
+    cancel_deadline();
+    request_deadline_ = boost::asio::steady_timer::time_point::max();
+
+    /* The request is either complete or malformed now. */
+    bool valid = static_cast<bool>(result);
+
+    /* Reserve a slot for the analysis. It is freed when the analysis is finished. */
+    if (!shed_) {
+        analysis_slot_ = std::make_unique<swd::analysis_slot>(admission_);
+        shed_ = !analysis_slot_->is_granted();
+    }
+
+    /* A shed request is answered right away, there is nothing expensive to do. */
+    if (shed_) {
+        process(valid);
+        start_write();
+        return;
+    }
+
+    /**
+     * Everything else is done by the analysis pool, so that this io thread is
+     * free again for the network handling of other connections.
+     */
+    analysis_pool_->post(
+        boost::bind(
+            &connection::handle_analysis,
+            shared_from_this(),
+            valid
+        )
+    );
+}
+
+void swd::connection::handle_analysis(bool valid) {
+    process(valid);
+
+    analysis_slot_.reset();
+
+    /* Continue on the strand of the connection to send the reply. */
+    strand_.post(
+        boost::bind(
+            &connection::start_write,
+            shared_from_this()
+        )
+    );
+}
+
+void swd::connection::process(bool valid) {
     /* The handler used to process the reply. */
     swd::reply_handler reply_handler(reply_);
 
-    try {
-        if (!result) {
-            throw swd::exceptions::connection_exception(
-                STATUS_BAD_REQUEST,
-                "Bad request from " + remote_address_.to_string()
-            );
-        }
+    /**
+     * Rejections are reported as status values instead of exceptions, so a
+     * flood of bad requests is as cheap to answer as a good request.
+     */
+    analyze(valid);
 
-        /* Try to add a profile for the request. */
-        try {
-            swd::profile_ptr profile = database_->get_profile(
-                remote_address_.to_string(),
-                request_->get_profile_id()
-            );
-
-            request_->set_profile(profile);
-        } catch (const swd::exceptions::database_exception& e) {
-            throw swd::exceptions::connection_exception(
-                STATUS_BAD_REQUEST,
-                "Database error when fetching profile: " + e.get_message()
-            );
-        }
+    /* Encode the reply. */
+    reply_handler.encode();
+}
 
-        /* The handler used to process the incoming request. */
-        swd::request_handler request_handler(request_, cache_, storage_);
+void swd::connection::analyze(bool valid) {
+    /* Do not touch the database or crypto if the request is shed anyway. */
+    if (shed_) {
+        /* Shed requests are logged in aggregate, an overload should not flood the log. */
+        unsigned long shed = admission_->count_shed();
 
-        /* Only continue processing the reply if it is signed correctly. */
-        if (!request_handler.valid_signature()) {
-            throw swd::exceptions::connection_exception(
-                STATUS_BAD_SIGNATURE,
-                "Bad signature from " + remote_address_.to_string()
-            );
+        if (shed > 0) {
+            swd::log::i()->send(swd::warning, "Overloaded, shed " + std::to_string(shed)
+             + " requests, the last one from " + remote_address_.to_string());
         }
 
-        /**
-         * Before the request can be processed the input has to be transfered
-         * from the encoded json string to a swd::parameters list.
-         */
-        if (!request_handler.decode()) {
-            throw swd::exceptions::connection_exception(
-                STATUS_BAD_JSON,
-                "Bad json from " + remote_address_.to_string()
-            );
-        }
+        return reject(
+            STATUS_OVERLOADED,
+            "Overloaded, shedding request from " + remote_address_.to_string(),
+            false
+        );
+    }
 
-        /* Check profile for outdated cache. */
-        swd::profile_ptr profile = request_->get_profile();
+    /**
+     * Cheap checks come before any database or crypto work, so that floods
+     * of junk frames can not saturate the database. Sources that fail too
+     * often are rejected right away.
+     */
+    if (admission_->is_blocked(remote_address_)) {
+        return reject(
+            STATUS_BAD_REQUEST,
+            "Too many failed requests from " + remote_address_.to_string()
+        );
+    }
 
-        if (profile->is_cache_outdated()) {
-            cache_->reset_profile(profile->get_id());
-        }
+    if (!valid) {
+        admission_->add_failure(remote_address_);
 
-        /* Process the request. */
-        std::vector<std::string> threats;
+        return reject(
+            STATUS_BAD_REQUEST,
+            "Bad request from " + remote_address_.to_string()
+        );
+    }
 
-        try {
-            swd::parameters parameters = request_->get_parameters();
+    /* The signature is a hex encoded hmac-sha256. */
+    if (request_->get_signature().length() != 64) {
+        admission_->add_failure(remote_address_);
 
-            /** Check security limitations first. */
-            int max_params = swd::config::i()->get<int>("max-parameters");
+        return reject(
+            STATUS_BAD_SIGNATURE,
+            "Bad signature from " + remote_address_.to_string()
+        );
+    }
 
-            if ((max_params > -1) && (parameters.size() > max_params)) {
-                throw swd::exceptions::connection_exception(
-                    STATUS_BAD_REQUEST,
-                    "Too many parameters"
-                );
-            }
+    /* The content has to be a json object, unless it is still compressed. */
+    std::size_t start = request_->get_content().find_first_not_of(" \t\n\r");
 
-            int max_length_path = swd::config::i()->get<int>("max-length-path");
-            int max_length_value = swd::config::i()->get<int>("max-length-value");
-
-            if ((max_length_path > -1) || (max_length_value > -1)) {
-                for (const auto& parameter: parameters) {
-                    if ((max_length_path > -1) && (parameter->get_path().length() > max_length_path)) {
-                        throw swd::exceptions::connection_exception(
-                            STATUS_BAD_REQUEST,
-                            "Too long parameter path"
-                        );
-                    }
-
-                    if ((max_length_value > -1) && (parameter->get_value().length() > max_length_value)) {
-                        throw swd::exceptions::connection_exception(
-                            STATUS_BAD_REQUEST,
-                            "Too long parameter value"
-                        );
-                    }
-                }
-            }
+    if (!request_->is_compressed() && ((start == std::string::npos) ||
+     (request_->get_content()[start] != '{'))) {
+        admission_->add_failure(remote_address_);
 
-            if (profile->is_flooding_enabled()) {
-                if (database_->is_flooding(request_->get_client_ip(), profile->get_id())) {
-                    throw swd::exceptions::connection_exception(
-                        STATUS_BAD_REQUEST,
-                        "Too many requests"
-                    );
-                }
-            }
+        return reject(
+            STATUS_BAD_JSON,
+            "Bad json from " + remote_address_.to_string()
+        );
+    }
 
-            /* Time to analyze the request. */
-            request_handler.process();
-        } catch (const swd::exceptions::database_exception& e) {
-            /**
-             * Problems with the database result in a bad request. If protection
-             * is enabled access to the site will not be granted.
-             */
-            throw swd::exceptions::connection_exception(
-                STATUS_BAD_REQUEST,
-                "Database error: " + e.get_message()
-            );
-        }
+    /* Unknown profiles are recognized without a query. */
+    if (!cache_->has_profile_id(request_->get_profile_id())) {
+        admission_->add_failure(remote_address_);
+
+        return reject(
+            STATUS_BAD_REQUEST,
+            "Unknown profile from " + remote_address_.to_string()
+        );
+    }
+
+    /* Try to add a profile for the request. */
+    try {
+        swd::profile_ptr profile = database_->get_profile(
+            remote_address_.to_string(),
+            request_->get_profile_id()
+        );
+
+        request_->set_profile(profile);
+    } catch (const swd::exceptions::database_exception& e) {
+        return reject(
+            STATUS_BAD_REQUEST,
+            "Database error when fetching profile: " + e.get_message()
+        );
+    }
+
+    /* The handler used to process the incoming request. */
+    swd::request_handler request_handler(request_, cache_, storage_);
+
+    /* Security limitations are enforced while decoding. */
+    request_handler.set_limits(
+        swd::config::i()->get<int>("max-parameters"),
+        swd::config::i()->get<int>("max-length-path"),
+        swd::config::i()->get<int>("max-length-value"),
+        swd::config::i()->get<int>("max-length-inflated")
+    );
+
+    request_handler.set_full_scan(swd::config::i()->defined("full-scan"));
+    request_handler.set_scan_window(
+        swd::config::i()->get<int>("scan-window-size"),
+        swd::config::i()->get<int>("scan-unbounded-span")
+    );
+    request_handler.set_scan_pool(scan_pool_);
+
+    /* Only continue processing the reply if it is signed correctly. */
+    if (!request_handler.valid_signature()) {
+        admission_->add_failure(remote_address_);
+
+        return reject(
+            STATUS_BAD_SIGNATURE,
+            "Bad signature from " + remote_address_.to_string()
+        );
+    }
+
+    /**
+     * Before the request can be processed the input has to be transfered
+     * from the encoded json string to a swd::parameters list.
+     */
+    int status = request_handler.decode();
+
+    if (status == STATUS_BAD_JSON) {
+        admission_->add_failure(remote_address_);
+
+        return reject(
+            STATUS_BAD_JSON,
+            "Bad json from " + remote_address_.to_string()
+        );
+    } else if (status != STATUS_OK) {
+        return reject(
+            status,
+            request_handler.get_message()
+        );
+    }
+
+    /* Check profile for outdated cache. */
+    swd::profile_ptr profile = request_->get_profile();
+
+    if (profile->is_cache_outdated()) {
+        cache_->reset_profile(profile->get_id());
+    }
 
-        if (profile->get_mode() == MODE_ACTIVE) {
-            if (request_->is_threat()) {
-                reply_->set_status(STATUS_CRITICAL_ATTACK);
-            } else if (request_->has_threats()) {
-                reply_->set_threats(request_handler.get_threats());
-                reply_->set_status(STATUS_ATTACK);
-            } else {
-                reply_->set_status(STATUS_OK);
+    /* Process the request. */
+    std::vector<std::string> threats;
+
+    try {
+        if (profile->is_flooding_enabled()) {
+            if (database_->is_flooding(request_->get_client_ip(), profile->get_id())) {
+                return reject(
+                    STATUS_BAD_REQUEST,
+                    "Too many requests"
+                );
             }
-        } else {
-            reply_->set_status(STATUS_OK);
         }
-    } catch (const swd::exceptions::connection_exception& e) {
-        swd::log::i()->send(swd::warning, e.get_message());
 
-        if (!request_->get_profile() || request_->get_profile()->get_mode() == MODE_ACTIVE) {
-            reply_->set_status(e.get_code());
-            reply_->set_message(e.get_message());
+        /* Time to analyze the request. */
+        request_handler.process();
+    } catch (const swd::exceptions::database_exception& e) {
+        /**
+         * Problems with the database result in a bad request. If protection
+         * is enabled access to the site will not be granted.
+         */
+        return reject(
+            STATUS_BAD_REQUEST,
+            "Database error: " + e.get_message()
+        );
+    }
+
+    if (profile->get_mode() == MODE_ACTIVE) {
+        if (request_->is_threat()) {
+            reply_->set_status(STATUS_CRITICAL_ATTACK);
+        } else if (request_->has_threats()) {
+            reply_->set_threats(request_handler.get_threats());
+            reply_->set_status(STATUS_ATTACK);
         } else {
             reply_->set_status(STATUS_OK);
         }
+    } else {
+        reply_->set_status(STATUS_OK);
     }
+}
 
-    /* Encode the reply. */
-    reply_handler.encode();
+void swd::connection::reject(int code, const std::string& message, bool report) {
+    if (report) {
+        swd::log::i()->send(swd::warning, message);
+    }
+
+    if (shed_ && fail_open_) {
+        reply_->set_status(STATUS_OK);
+    } else if (!request_->get_profile() || request_->get_profile()->get_mode() == MODE_ACTIVE) {
+        reply_->set_status(code);
+        reply_->set_message(message);
+    } else {
+        reply_->set_status(STATUS_OK);
+    }
+}
+
+void swd::connection::start_write() {
+    /* Send the answer to the client. The client has to accept it in time. */
+    set_deadline(timeout_idle_);
 
-    /* Send the answer to the client. */
     if (ssl_) {
         boost::asio::async_write(
-            ssl_socket_,
+            *ssl_socket_,
             reply_->to_buffers(),
             strand_.wrap(
                 boost::bind(
@@ -327,7 +544,7 @@ void swd::connection::handle_read(const boost::system::error_code& e,
         );
     } else {
         boost::asio::async_write(
-            socket_,
+            *socket_,
             reply_->to_buffers(),
             strand_.wrap(
                 boost::bind(
@@ -341,14 +558,16 @@ void swd::connection::handle_read(const boost::system::error_code& e,
 }
 
 void swd::connection::handle_write(const boost::system::error_code& e) {
+    cancel_deadline();
+
     if (!e) {
         boost::system::error_code ignored_ec;
 
         /* Initiate graceful connection closure. */
         if (ssl_) {
-            ssl_socket_.shutdown(ignored_ec);
+            ssl_socket_->shutdown(ignored_ec);
         } else {
-            socket_.shutdown(boost::asio::ip::tcp::socket::shutdown_both, ignored_ec);
+            socket_->shutdown(boost::asio::ip::tcp::socket::shutdown_both, ignored_ec);
         }
     }
 
@@ -359,3 +578,59 @@ void swd::connection::handle_write(const boost::system::error_code& e) {
      * destructor closes the socket.
      */
 }
+
+void swd::connection::set_deadline(int timeout) {
+    boost::asio::steady_timer::time_point deadline = request_deadline_;
+
+    if (timeout > 0) {
+        boost::asio::steady_timer::time_point timeout_deadline =
+         boost::asio::steady_timer::clock_type::now() + std::chrono::seconds(timeout);
+
+        if ((deadline == boost::asio::steady_timer::time_point()) || (timeout_deadline < deadline)) {
+            deadline = timeout_deadline;
+        }
+    }
+
+    /* No limit at all, so there is no need to wait for anything. */
+    if ((deadline == boost::asio::steady_timer::time_point()) ||
+     (deadline == boost::asio::steady_timer::time_point::max())) {
+        cancel_deadline();
+        return;
+    }
+
+    /* Setting the expiry cancels a possibly pending wait. */
+    timer_.expires_at(deadline);
+
+    timer_.async_wait(
+        strand_.wrap(
+            boost::bind(
+                &connection::handle_deadline,
+                shared_from_this(),
+                boost::asio::placeholders::error
+            )
+        )
+    );
+}
+
+void swd::connection::cancel_deadline() {
+    boost::system::error_code ignored_ec;
+    timer_.cancel(ignored_ec);
+}
+
+void swd::connection::handle_deadline(const boost::system::error_code& e) {
+    /* The timer was cancelled or rearmed in the meantime. */
+    if (e == boost::asio::error::operation_aborted) {
+        return;
+    }
+
+    if (timer_.expiry() > boost::asio::steady_timer::clock_type::now()) {
+        return;
+    }
+
+    swd::log::i()->send(swd::warning, "Timeout of connection with "
+     + remote_address_.to_string());
+
+    /* Abort all pending operations, this destroys the connection afterwards. */
+    boost::system::error_code ignored_ec;
+    socket().close(ignored_ec);
+}
@@ -29,6 +29,7 @@
  * files in the program, then also delete it here.
  */
 
+#include <map>
 #include <sstream>
 #include <thread>
 #include <chrono>
@@ -118,10 +119,12 @@ swd::profile_ptr swd::database::get_profile(const std::string& server_ip,
     dbi_conn_quote_string(conn_, &server_ip_esc);
 
     /* Insert the ip and execute the query. */
-    dbi_result res = dbi_conn_queryf(conn_, "SELECT id, hmac_key, mode, "
-     "whitelist_enabled, blacklist_enabled, integrity_enabled, flooding_enabled, "
-     "blacklist_threshold, cache_outdated FROM profiles WHERE %s LIKE "
-     "prepare_wildcard(server_ip) AND id = %llu", server_ip_esc, profile_id);
+    /* Every disabled tag adds a row, so that a single query is enough. */
+    dbi_result res = dbi_conn_queryf(conn_, "SELECT p.id, p.hmac_key, p.mode, "
+     "p.whitelist_enabled, p.blacklist_enabled, p.integrity_enabled, p.flooding_enabled, "
+     "p.blacklist_threshold, p.cache_outdated, t.tag_id FROM profiles p LEFT JOIN "
+     "tags_profiles t ON t.profile_id = p.id WHERE %s LIKE prepare_wildcard(p.server_ip) "
+     "AND p.id = %llu", server_ip_esc, profile_id);
 
     /* Don't forget to free server_ip_esc to avoid a memory leak. */
     free(server_ip_esc);
@@ -130,7 +133,7 @@ swd::profile_ptr swd::database::get_profile(const std::string& server_ip,
         throw swd::exceptions::database_exception("Can't execute profile query");
     }
 
-    if (dbi_result_get_numrows(res) != 1) {
+    if (dbi_result_get_numrows(res) < 1) {
         throw swd::exceptions::database_exception("Can't get profile");
     }
 
@@ -150,6 +153,12 @@ swd::profile_ptr swd::database::get_profile(const std::string& server_ip,
     profile->set_blacklist_threshold(dbi_result_get_int(res, "blacklist_threshold"));
     profile->set_cache_outdated(dbi_result_get_uint(res, "cache_outdated") == 1);
 
+    do {
+        if (!dbi_result_field_is_null(res, "tag_id")) {
+            profile->add_disabled_tag(dbi_result_get_ulonglong(res, "tag_id"));
+        }
+    } while (dbi_result_next_row(res));
+
     dbi_result_free(res);
 
     return profile;
@@ -222,9 +231,55 @@ swd::blacklist_filters swd::database::get_blacklist_filters() {
 
     dbi_result_free(res);
 
+    res = dbi_conn_query(conn_, "SELECT tag_id, filter_id FROM tags_filters");
+
+    if (!res) {
+        throw swd::exceptions::database_exception("Can't execute tags_filters query");
+    }
+
+    std::map<unsigned long long, swd::blacklist_filter_ptr> filters_by_id;
+
+    for (const auto& filter: filters) {
+        filters_by_id[filter->get_id()] = filter;
+    }
+
+    while (dbi_result_next_row(res)) {
+        auto it = filters_by_id.find(dbi_result_get_ulonglong(res, "filter_id"));
+
+        if (it != filters_by_id.end()) {
+            it->second->add_tag(dbi_result_get_ulonglong(res, "tag_id"));
+        }
+    }
+
+    dbi_result_free(res);
+
     return filters;
 }
 
+std::vector<unsigned long long> swd::database::get_profile_ids() {
+    swd::log::i()->send(swd::notice, "Get profile ids from db");
+
+    ensure_connection();
+
+    boost::unique_lock scoped_lock(dbi_mutex_);
+
+    dbi_result res = dbi_conn_query(conn_, "SELECT id FROM profiles");
+
+    if (!res) {
+        throw swd::exceptions::database_exception("Can't execute profile ids query");
+    }
+
+    std::vector<unsigned long long> profile_ids;
+
+    while (dbi_result_next_row(res)) {
+        profile_ids.push_back(dbi_result_get_ulonglong(res, "id"));
+    }
+
+    dbi_result_free(res);
+
+    return profile_ids;
+}
+
 swd::whitelist_rules swd::database::get_whitelist_rules(const unsigned long long& profile_id,
  const std::string& caller, const std::string& path) {
     swd::log::i()->send(swd::notice, "Get whitelist rules from db");
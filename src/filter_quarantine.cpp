@@ -0,0 +1,71 @@
+/**
+ * Shadow Daemon -- Web Application Firewall
+ *
+ *   Copyright (C) 2014-2022 Hendrik Buchwald <hb@zecure.org>
+ *
+ * This file is part of Shadow Daemon. Shadow Daemon is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, version 2.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#include <string>
+
+#include "filter_quarantine.h"
+#include "log.h"
+
+/* The min number of evaluations before a filter is judged. */
+#define MIN_EVALUATIONS 1000
+
+void swd::filter_quarantine::set_budget(int nanoseconds, int sample_rate) {
+    budget_ = nanoseconds;
+    sample_rate_ = ((sample_rate > 0) ? sample_rate : 1);
+}
+
+bool swd::filter_quarantine::skip(swd::filter_stats& stats) const {
+    if (!stats.is_quarantined()) {
+        return false;
+    }
+
+    return ((stats.add_quarantined_input() % sample_rate_) != 0);
+}
+
+void swd::filter_quarantine::check(unsigned long long id, swd::filter_stats& stats) const {
+    int budget = budget_;
+
+    if ((budget < 0) || stats.is_quarantined()) {
+        return;
+    }
+
+    if (stats.get_evaluations() < MIN_EVALUATIONS) {
+        return;
+    }
+
+    unsigned long long average = stats.get_average_nanoseconds();
+
+    if ((average > (unsigned long long) budget) && stats.quarantine()) {
+        swd::log::i()->send(swd::uncritical_error, "Blacklist filter "
+         + std::to_string(id) + " quarantined, average cost "
+         + std::to_string(average) + " ns");
+    }
+}
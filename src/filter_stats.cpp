@@ -0,0 +1,88 @@
+/**
+ * Shadow Daemon -- Web Application Firewall
+ *
+ *   Copyright (C) 2014-2022 Hendrik Buchwald <hb@zecure.org>
+ *
+ * This file is part of Shadow Daemon. Shadow Daemon is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, version 2.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#include "filter_stats.h"
+
+void swd::filter_stats::add_evaluation(unsigned long long nanoseconds, bool match) {
+    evaluations_.fetch_add(1, std::memory_order_relaxed);
+    nanoseconds_.fetch_add(nanoseconds, std::memory_order_relaxed);
+
+    if (match) {
+        matches_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void swd::filter_stats::add_abort(unsigned long long nanoseconds) {
+    aborts_.fetch_add(1, std::memory_order_relaxed);
+    add_evaluation(nanoseconds, true);
+}
+
+unsigned long long swd::filter_stats::add_quarantined_input() {
+    return quarantined_inputs_.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool swd::filter_stats::quarantine() {
+    return !quarantined_.exchange(true);
+}
+
+bool swd::filter_stats::is_quarantined() const {
+    return quarantined_.load(std::memory_order_relaxed);
+}
+
+unsigned long long swd::filter_stats::get_evaluations() const {
+    return evaluations_.load(std::memory_order_relaxed);
+}
+
+unsigned long long swd::filter_stats::get_matches() const {
+    return matches_.load(std::memory_order_relaxed);
+}
+
+unsigned long long swd::filter_stats::get_aborts() const {
+    return aborts_.load(std::memory_order_relaxed);
+}
+
+unsigned long long swd::filter_stats::get_quarantined_inputs() const {
+    return quarantined_inputs_.load(std::memory_order_relaxed);
+}
+
+unsigned long long swd::filter_stats::get_nanoseconds() const {
+    return nanoseconds_.load(std::memory_order_relaxed);
+}
+
+unsigned long long swd::filter_stats::get_average_nanoseconds() const {
+    unsigned long long evaluations = get_evaluations();
+
+    if (evaluations == 0) {
+        return 0;
+    }
+
+    return get_nanoseconds() / evaluations;
+}
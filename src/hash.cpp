@@ -35,7 +35,7 @@ void swd::hash::set_algorithm(const std::string& algorithm) {
     algorithm_ = algorithm;
 }
 
-std::string swd::hash::get_algorithm() const {
+const std::string& swd::hash::get_algorithm() const {
     return algorithm_;
 }
 
@@ -43,6 +43,6 @@ void swd::hash::set_digest(const std::string& digest) {
     digest_ = digest;
 }
 
-std::string swd::hash::get_digest() const {
+const std::string& swd::hash::get_digest() const {
     return digest_;
 }
@@ -43,7 +43,7 @@ void swd::integrity_rule::set_algorithm(const std::string& algorithm) {
     algorithm_ = algorithm;
 }
 
-std::string swd::integrity_rule::get_algorithm() const {
+const std::string& swd::integrity_rule::get_algorithm() const {
     return algorithm_;
 }
 
@@ -51,7 +51,7 @@ void swd::integrity_rule::set_digest(const std::string& digest) {
     digest_ = digest;
 }
 
-std::string swd::integrity_rule::get_digest() const {
+const std::string& swd::integrity_rule::get_digest() const {
     return digest_;
 }
 
@@ -0,0 +1,595 @@
+/**
+ * Shadow Daemon -- Web Application Firewall
+ *
+ *   Copyright (C) 2014-2022 Hendrik Buchwald <hb@zecure.org>
+ *
+ * This file is part of Shadow Daemon. Shadow Daemon is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, version 2.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#include <cstring>
+#include <utility>
+
+#include "json_decoder.h"
+#include "shared.h"
+
+/**
+ * Nesting limit for values that are skipped. Deeper documents are rejected
+ * to keep the recursion bounded.
+ */
+#define MAX_DEPTH 256
+
+swd::json_decoder::json_decoder(swd::request_ptr request, int max_parameters,
+ int max_length_path, int max_length_value) :
+ request_(std::move(request)),
+ max_parameters_(max_parameters),
+ max_length_path_(max_length_path),
+ max_length_value_(max_length_value) {
+}
+
+int swd::json_decoder::decode(const std::string& content) {
+    pos_ = content.data();
+    end_ = content.data() + content.size();
+
+    /* The three mandatory values must not be missing or null. */
+    bool client_ip = false;
+    bool input = false;
+    bool hashes = false;
+
+    bool valid = parse_root(client_ip, input, hashes);
+
+    if (exceeded_) {
+        return STATUS_BAD_REQUEST;
+    }
+
+    /* There must not be anything but whitespace after the root object. */
+    skip_whitespace();
+
+    if (!valid || (pos_ != end_) || !client_ip || !input || !hashes) {
+        message_ = "Bad json";
+        return STATUS_BAD_JSON;
+    }
+
+    return STATUS_OK;
+}
+
+const std::string& swd::json_decoder::get_message() const {
+    return message_;
+}
+
+const std::vector<std::string>& swd::json_decoder::get_skipped() const {
+    return skipped_;
+}
+
+bool swd::json_decoder::parse_root(bool& client_ip, bool& input, bool& hashes) {
+    skip_whitespace();
+
+    if ((pos_ == end_) || (*pos_ != '{')) {
+        return false;
+    }
+
+    pos_++;
+    skip_whitespace();
+
+    if ((pos_ != end_) && (*pos_ == '}')) {
+        pos_++;
+        return true;
+    }
+
+    std::string key;
+    std::string value;
+
+    while (true) {
+        skip_whitespace();
+
+        key.clear();
+
+        if (!parse_string(key)) {
+            return false;
+        }
+
+        skip_whitespace();
+
+        if ((pos_ == end_) || (*pos_ != ':')) {
+            return false;
+        }
+
+        pos_++;
+        skip_whitespace();
+
+        /* Like with most json parsers the last duplicate key wins. */
+        bool defined;
+
+        if (key == "client_ip") {
+            if (!parse_text(value, defined)) {
+                return false;
+            }
+
+            request_->set_client_ip(value);
+            client_ip = defined;
+        } else if (key == "caller") {
+            if (!parse_text(value, defined)) {
+                return false;
+            }
+
+            request_->set_caller(value);
+        } else if (key == "resource") {
+            if (!parse_text(value, defined)) {
+                return false;
+            }
+
+            request_->set_resource(value);
+        } else if (key == "input") {
+            /* The pairs of a duplicate key are replaced and not merged. */
+            request_->clear_parameters();
+            parameters_ = 0;
+
+            if (!parse_pairs(false, defined)) {
+                return false;
+            }
+
+            input = defined;
+        } else if (key == "hashes") {
+            request_->clear_hashes();
+
+            if (!parse_pairs(true, defined)) {
+                return false;
+            }
+
+            hashes = defined;
+        } else if (!skip_value()) {
+            return false;
+        }
+
+        skip_whitespace();
+
+        if (pos_ == end_) {
+            return false;
+        } else if (*pos_ == ',') {
+            pos_++;
+        } else if (*pos_ == '}') {
+            pos_++;
+            return true;
+        } else {
+            return false;
+        }
+    }
+}
+
+bool swd::json_decoder::parse_text(std::string& output, bool& defined) {
+    output.clear();
+    defined = true;
+
+    if (pos_ == end_) {
+        return false;
+    }
+
+    switch (*pos_) {
+        case '"':
+            return parse_string(output);
+        case 't':
+            output = "true";
+            return consume("true");
+        case 'f':
+            output = "false";
+            return consume("false");
+        case 'n':
+            defined = false;
+            return consume("null");
+        default:
+            /* Objects and arrays can not be converted to text. */
+            return parse_number(output);
+    }
+}
+
+bool swd::json_decoder::parse_pairs(bool hashes, bool& defined) {
+    defined = true;
+
+    if (pos_ == end_) {
+        return false;
+    }
+
+    char close;
+
+    if (*pos_ == '{') {
+        close = '}';
+    } else if (*pos_ == '[') {
+        close = ']';
+    } else {
+        /* Scalars do not contain any pairs, only null counts as missing. */
+        std::string ignored;
+        return parse_text(ignored, defined);
+    }
+
+    pos_++;
+    skip_whitespace();
+
+    if ((pos_ != end_) && (*pos_ == close)) {
+        pos_++;
+        return true;
+    }
+
+    std::string key;
+    std::string value;
+    unsigned long long index = 0;
+
+    while (true) {
+        skip_whitespace();
+
+        if (!hashes && (max_parameters_ > -1) && (++parameters_ > max_parameters_)) {
+            return exceed("Too many parameters");
+        }
+
+        /* The keys of arrays are their indexes. */
+        if (close == '}') {
+            key.clear();
+
+            if (!parse_string(key, (hashes ? -1 : max_length_path_), "Too long parameter path")) {
+                return false;
+            }
+
+            skip_whitespace();
+
+            if ((pos_ == end_) || (*pos_ != ':')) {
+                return false;
+            }
+
+            pos_++;
+            skip_whitespace();
+        } else {
+            key = std::to_string(index++);
+
+            if (!hashes && (max_length_path_ > -1) && (key.length() > (std::size_t) max_length_path_)) {
+                return exceed("Too long parameter path");
+            }
+        }
+
+        if (pos_ == end_) {
+            return false;
+        }
+
+        bool nested = false;
+
+        if ((*pos_ == '{') || (*pos_ == '[')) {
+            /* Nested values can not be converted to text, so they are skipped and reported. */
+            if (!skip_value(1)) {
+                return false;
+            }
+
+            nested = true;
+        } else if (*pos_ == '"') {
+            value.clear();
+
+            if (!parse_string(value, (hashes ? -1 : max_length_value_), "Too long parameter value")) {
+                return false;
+            }
+        } else {
+            bool value_defined;
+
+            if (!parse_text(value, value_defined)) {
+                return false;
+            }
+
+            if (!hashes && (max_length_value_ > -1) && (value.length() > (std::size_t) max_length_value_)) {
+                return exceed("Too long parameter value");
+            }
+        }
+
+        if (nested) {
+            skipped_.push_back(key);
+        } else if (hashes) {
+            request_->add_hash(key, value);
+        } else {
+            request_->add_parameter(key, value);
+        }
+
+        skip_whitespace();
+
+        if (pos_ == end_) {
+            return false;
+        } else if (*pos_ == ',') {
+            pos_++;
+        } else if (*pos_ == close) {
+            pos_++;
+            return true;
+        } else {
+            return false;
+        }
+    }
+}
+
+bool swd::json_decoder::parse_string(std::string& output, int max_length,
+ const char* limit_message) {
+    if ((pos_ == end_) || (*pos_ != '"')) {
+        return false;
+    }
+
+    pos_++;
+
+    /* The next quote is searched only once, unless it turns out to be escaped. */
+    const char* quote = nullptr;
+
+    while (true) {
+        if (!quote || (quote < pos_)) {
+            quote = static_cast<const char*>(memchr(pos_, '"', end_ - pos_));
+
+            if (!quote) {
+                return false;
+            }
+        }
+
+        /* Copy everything up to the next escape sequence or the end at once. */
+        const char* backslash = static_cast<const char*>(memchr(pos_, '\\', quote - pos_));
+        const char* stop = (backslash ? backslash : quote);
+
+        output.append(pos_, stop);
+
+        if ((max_length > -1) && (output.length() > (std::size_t) max_length)) {
+            return exceed(limit_message);
+        }
+
+        if (!backslash) {
+            pos_ = quote + 1;
+            return true;
+        }
+
+        pos_ = backslash + 1;
+
+        if (pos_ == end_) {
+            return false;
+        }
+
+        switch (*pos_++) {
+            case '"':
+                output.push_back('"');
+                break;
+            case '\\':
+                output.push_back('\\');
+                break;
+            case '/':
+                output.push_back('/');
+                break;
+            case 'b':
+                output.push_back('\b');
+                break;
+            case 'f':
+                output.push_back('\f');
+                break;
+            case 'n':
+                output.push_back('\n');
+                break;
+            case 'r':
+                output.push_back('\r');
+                break;
+            case 't':
+                output.push_back('\t');
+                break;
+            case 'u': {
+                unsigned int code_point;
+
+                if (!parse_hex(code_point)) {
+                    return false;
+                }
+
+                /* A high surrogate has to be followed by a low surrogate. */
+                if ((code_point >= 0xD800) && (code_point <= 0xDBFF)) {
+                    unsigned int low;
+
+                    if ((end_ - pos_ < 2) || (pos_[0] != '\\') || (pos_[1] != 'u')) {
+                        return false;
+                    }
+
+                    pos_ += 2;
+
+                    if (!parse_hex(low) || (low < 0xDC00) || (low > 0xDFFF)) {
+                        return false;
+                    }
+
+                    code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+                }
+
+                /* Encode the code point as utf-8. */
+                if (code_point < 0x80) {
+                    output.push_back(static_cast<char>(code_point));
+                } else if (code_point < 0x800) {
+                    output.push_back(static_cast<char>(0xC0 | (code_point >> 6)));
+                    output.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+                } else if (code_point < 0x10000) {
+                    output.push_back(static_cast<char>(0xE0 | (code_point >> 12)));
+                    output.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+                    output.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+                } else {
+                    output.push_back(static_cast<char>(0xF0 | (code_point >> 18)));
+                    output.push_back(static_cast<char>(0x80 | ((code_point >> 12) & 0x3F)));
+                    output.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+                    output.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+                }
+
+                break;
+            }
+            default:
+                return false;
+        }
+    }
+}
+
+bool swd::json_decoder::parse_hex(unsigned int& code_point) {
+    if (end_ - pos_ < 4) {
+        return false;
+    }
+
+    code_point = 0;
+
+    for (int i = 0; i < 4; i++) {
+        char c = *pos_++;
+        code_point <<= 4;
+
+        if ((c >= '0') && (c <= '9')) {
+            code_point |= (c - '0');
+        } else if ((c >= 'a') && (c <= 'f')) {
+            code_point |= (c - 'a' + 10);
+        } else if ((c >= 'A') && (c <= 'F')) {
+            code_point |= (c - 'A' + 10);
+        } else {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool swd::json_decoder::parse_number(std::string& output) {
+    const char* begin = pos_;
+
+    auto digits = [this]() {
+        const char* start = pos_;
+
+        while ((pos_ != end_) && (*pos_ >= '0') && (*pos_ <= '9')) {
+            pos_++;
+        }
+
+        return (pos_ != start);
+    };
+
+    if ((pos_ != end_) && (*pos_ == '-')) {
+        pos_++;
+    }
+
+    if (!digits()) {
+        return false;
+    }
+
+    if ((pos_ != end_) && (*pos_ == '.')) {
+        pos_++;
+
+        if (!digits()) {
+            return false;
+        }
+    }
+
+    if ((pos_ != end_) && ((*pos_ == 'e') || (*pos_ == 'E'))) {
+        pos_++;
+
+        if ((pos_ != end_) && ((*pos_ == '+') || (*pos_ == '-'))) {
+            pos_++;
+        }
+
+        if (!digits()) {
+            return false;
+        }
+    }
+
+    output.assign(begin, pos_);
+
+    return true;
+}
+
+bool swd::json_decoder::skip_value(int depth) {
+    if ((pos_ == end_) || (depth > MAX_DEPTH)) {
+        return false;
+    }
+
+    if ((*pos_ == '{') || (*pos_ == '[')) {
+        char close = ((*pos_ == '{') ? '}' : ']');
+
+        pos_++;
+        skip_whitespace();
+
+        if ((pos_ != end_) && (*pos_ == close)) {
+            pos_++;
+            return true;
+        }
+
+        std::string key;
+
+        while (true) {
+            skip_whitespace();
+
+            if (close == '}') {
+                key.clear();
+
+                if (!parse_string(key)) {
+                    return false;
+                }
+
+                skip_whitespace();
+
+                if ((pos_ == end_) || (*pos_ != ':')) {
+                    return false;
+                }
+
+                pos_++;
+                skip_whitespace();
+            }
+
+            if (!skip_value(depth + 1)) {
+                return false;
+            }
+
+            skip_whitespace();
+
+            if (pos_ == end_) {
+                return false;
+            } else if (*pos_ == ',') {
+                pos_++;
+            } else if (*pos_ == close) {
+                pos_++;
+                return true;
+            } else {
+                return false;
+            }
+        }
+    }
+
+    std::string ignored;
+    bool defined;
+
+    return parse_text(ignored, defined);
+}
+
+bool swd::json_decoder::consume(const char* literal) {
+    std::size_t length = strlen(literal);
+
+    if (((std::size_t) (end_ - pos_) < length) || (memcmp(pos_, literal, length) != 0)) {
+        return false;
+    }
+
+    pos_ += length;
+
+    return true;
+}
+
+void swd::json_decoder::skip_whitespace() {
+    while ((pos_ != end_) && ((*pos_ == ' ') || (*pos_ == '\t') || (*pos_ == '\n') || (*pos_ == '\r'))) {
+        pos_++;
+    }
+}
+
+bool swd::json_decoder::exceed(const std::string& message) {
+    exceeded_ = true;
+    message_ = message;
+
+    return false;
+}
@@ -0,0 +1,351 @@
+/**
+ * Shadow Daemon -- Web Application Firewall
+ *
+ *   Copyright (C) 2014-2022 Hendrik Buchwald <hb@zecure.org>
+ *
+ * This file is part of Shadow Daemon. Shadow Daemon is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, version 2.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+
+#include "match_span.h"
+
+long swd::match_span::get_max_length(const std::string& regex) {
+    swd::match_span analyzer(regex);
+
+    long result = analyzer.parse_alternation();
+
+    /* Everything that is not understood completely might match anything. */
+    if (!analyzer.valid_ || (analyzer.pos_ != regex.length())) {
+        return UNBOUNDED;
+    }
+
+    return result;
+}
+
+swd::match_span::match_span(const std::string& regex) :
+ regex_(regex) {
+}
+
+long swd::match_span::parse_alternation() {
+    long result = parse_sequence();
+
+    while (valid_ && (pos_ < regex_.length()) && (regex_[pos_] == '|')) {
+        pos_++;
+
+        long alternative = parse_sequence();
+
+        if ((result == UNBOUNDED) || (alternative == UNBOUNDED)) {
+            result = UNBOUNDED;
+        } else if (alternative > result) {
+            result = alternative;
+        }
+    }
+
+    return result;
+}
+
+long swd::match_span::parse_sequence() {
+    long result = 0;
+
+    while (valid_ && (pos_ < regex_.length()) && (regex_[pos_] != '|') && (regex_[pos_] != ')')) {
+        long atom = parse_atom();
+
+        result = add(result, multiply(atom, parse_quantifier()));
+    }
+
+    return result;
+}
+
+long swd::match_span::parse_atom() {
+    char c = regex_[pos_++];
+
+    switch (c) {
+        case '(':
+            return parse_group();
+        case '[':
+            return parse_class();
+        case '^':
+        case '$':
+            return 0;
+        case '\\':
+            return parse_escape();
+        case '*':
+        case '+':
+        case '?':
+            /* A quantifier without atom is a syntax error. */
+            valid_ = false;
+            return UNBOUNDED;
+        default:
+            return 1;
+    }
+}
+
+long swd::match_span::parse_group() {
+    if ((pos_ < regex_.length()) && (regex_[pos_] == '?')) {
+        pos_++;
+
+        if (pos_ >= regex_.length()) {
+            valid_ = false;
+            return UNBOUNDED;
+        }
+
+        char c = regex_[pos_];
+
+        if ((c == ':') || (c == '=') || (c == '!')) {
+            /* Lookarounds examine characters as well, so they count towards the span. */
+            pos_++;
+        } else if ((c == '<') && (pos_ + 1 < regex_.length()) &&
+         ((regex_[pos_ + 1] == '=') || (regex_[pos_ + 1] == '!'))) {
+            pos_ += 2;
+        } else {
+            /* Inline modifiers like (?i) or (?i:...), others like (?x) change the syntax. */
+            while ((pos_ < regex_.length()) &&
+             (isalpha((unsigned char)regex_[pos_]) || (regex_[pos_] == '-'))) {
+                if (!strchr("ims-", regex_[pos_])) {
+                    valid_ = false;
+                    return UNBOUNDED;
+                }
+
+                pos_++;
+            }
+
+            if (pos_ >= regex_.length()) {
+                valid_ = false;
+                return UNBOUNDED;
+            }
+
+            if (regex_[pos_] == ')') {
+                pos_++;
+                return 0;
+            }
+
+            if (regex_[pos_] != ':') {
+                valid_ = false;
+                return UNBOUNDED;
+            }
+
+            pos_++;
+        }
+    }
+
+    long result = parse_alternation();
+
+    if ((pos_ >= regex_.length()) || (regex_[pos_] != ')')) {
+        valid_ = false;
+        return UNBOUNDED;
+    }
+
+    pos_++;
+
+    return result;
+}
+
+long swd::match_span::parse_class() {
+    bool first = true;
+
+    if ((pos_ < regex_.length()) && (regex_[pos_] == '^')) {
+        pos_++;
+    }
+
+    while (pos_ < regex_.length()) {
+        char c = regex_[pos_++];
+
+        /* A closing bracket at the beginning is a literal. */
+        if ((c == ']') && !first) {
+            return 1;
+        }
+
+        first = false;
+
+        if (c == '\\') {
+            pos_++;
+        } else if ((c == '[') && (pos_ < regex_.length()) && strchr(":=.", regex_[pos_])) {
+            /* Named classes like [:alpha:] and similar elements end with their own bracket. */
+            std::size_t end = regex_.find(std::string(1, regex_[pos_]) + "]", pos_ + 1);
+
+            if (end == std::string::npos) {
+                valid_ = false;
+                return UNBOUNDED;
+            }
+
+            pos_ = end + 2;
+        }
+    }
+
+    valid_ = false;
+    return UNBOUNDED;
+}
+
+long swd::match_span::parse_escape() {
+    if (pos_ >= regex_.length()) {
+        valid_ = false;
+        return UNBOUNDED;
+    }
+
+    char c = regex_[pos_++];
+
+    switch (c) {
+        case 'b':
+        case 'B':
+        case 'A':
+        case 'z':
+        case 'Z':
+        case 'G':
+        case '<':
+        case '>':
+            return 0;
+        case 'd':
+        case 'w':
+        case 's':
+        case 'D':
+        case 'W':
+        case 'S':
+        case 'n':
+        case 't':
+        case 'r':
+        case 'f':
+        case 'v':
+            return 1;
+        case 'x': {
+            std::size_t length = 0;
+
+            while ((length < 2) && (pos_ + length < regex_.length()) &&
+             isxdigit((unsigned char)regex_[pos_ + length])) {
+                length++;
+            }
+
+            if (length == 0) {
+                valid_ = false;
+                return UNBOUNDED;
+            }
+
+            pos_ += length;
+            return 1;
+        }
+        default:
+            /* Back references, unicode properties and similar are not analyzed. */
+            if (isalnum((unsigned char)c)) {
+                valid_ = false;
+                return UNBOUNDED;
+            }
+
+            return 1;
+    }
+}
+
+long swd::match_span::parse_quantifier() {
+    if (pos_ >= regex_.length()) {
+        return 1;
+    }
+
+    long result;
+    char c = regex_[pos_];
+
+    if ((c == '*') || (c == '+')) {
+        result = UNBOUNDED;
+        pos_++;
+    } else if (c == '?') {
+        result = 1;
+        pos_++;
+    } else if (c == '{') {
+        std::size_t end = pos_ + 1;
+
+        while ((end < regex_.length()) && isdigit((unsigned char)regex_[end])) {
+            end++;
+        }
+
+        /* Without a number the brace is a literal. */
+        if (end == (pos_ + 1)) {
+            return 1;
+        }
+
+        if ((end >= regex_.length()) || ((regex_[end] != '}') && (regex_[end] != ','))) {
+            valid_ = false;
+            return UNBOUNDED;
+        }
+
+        std::string minimum = regex_.substr(pos_ + 1, end - pos_ - 1);
+        std::size_t upper = end;
+
+        if (regex_[end] == ',') {
+            upper = ++end;
+
+            while ((end < regex_.length()) && isdigit((unsigned char)regex_[end])) {
+                end++;
+            }
+
+            if ((end >= regex_.length()) || (regex_[end] != '}')) {
+                valid_ = false;
+                return UNBOUNDED;
+            }
+        }
+
+        /* An open range like {2,} has no upper bound. */
+        if (upper == end) {
+            result = (regex_[upper - 1] == ',' ? UNBOUNDED : multiply(1, strtol(minimum.c_str(), nullptr, 10)));
+        } else {
+            result = multiply(1, strtol(regex_.substr(upper, end - upper).c_str(), nullptr, 10));
+        }
+
+        pos_ = end + 1;
+    } else {
+        return 1;
+    }
+
+    /* Lazy and possessive modifiers. */
+    if ((pos_ < regex_.length()) && ((regex_[pos_] == '?') || (regex_[pos_] == '+'))) {
+        pos_++;
+    }
+
+    return result;
+}
+
+long swd::match_span::add(long a, long b) {
+    if ((a == UNBOUNDED) || (b == UNBOUNDED) || (a + b > MAX_LENGTH)) {
+        return UNBOUNDED;
+    }
+
+    return (a + b);
+}
+
+long swd::match_span::multiply(long a, long b) {
+    if ((a == UNBOUNDED) || (b == UNBOUNDED)) {
+        return UNBOUNDED;
+    }
+
+    if ((a == 0) || (b == 0)) {
+        return 0;
+    }
+
+    if ((b > MAX_LENGTH) || (a > MAX_LENGTH / b)) {
+        return UNBOUNDED;
+    }
+
+    return (a * b);
+}
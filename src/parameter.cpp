@@ -35,7 +35,7 @@ void swd::parameter::set_path(const std::string& path) {
     path_ = path;
 }
 
-std::string swd::parameter::get_path() const {
+const std::string& swd::parameter::get_path() const {
     return path_;
 }
 
@@ -43,7 +43,7 @@ void swd::parameter::set_value(const std::string& value) {
     value_ = value;
 }
 
-std::string swd::parameter::get_value() const {
+const std::string& swd::parameter::get_value() const {
     return value_;
 }
 
@@ -35,7 +35,7 @@ void swd::profile::set_server_ip(const std::string& server_ip) {
     server_ip_ = server_ip;
 }
 
-std::string swd::profile::get_server_ip() const {
+const std::string& swd::profile::get_server_ip() const {
     return server_ip_;
 }
 
@@ -91,7 +91,7 @@ void swd::profile::set_key(const std::string& key) {
     key_ = key;
 }
 
-std::string swd::profile::get_key() const {
+const std::string& swd::profile::get_key() const {
     return key_;
 }
 
@@ -110,3 +110,11 @@ void swd::profile::set_cache_outdated(const bool& cache_outdated) {
 bool swd::profile::is_cache_outdated() const {
     return cache_outdated_;
 }
+
+void swd::profile::add_disabled_tag(const unsigned long long& tag_id) {
+    disabled_tags_.insert(tag_id);
+}
+
+const std::set<unsigned long long>& swd::profile::get_disabled_tags() const {
+    return disabled_tags_;
+}
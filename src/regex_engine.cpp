@@ -0,0 +1,260 @@
+/**
+ * Shadow Daemon -- Web Application Firewall
+ *
+ *   Copyright (C) 2014-2022 Hendrik Buchwald <hb@zecure.org>
+ *
+ * This file is part of Shadow Daemon. Shadow Daemon is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, version 2.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#include <stdexcept>
+#include <boost/make_shared.hpp>
+#include <boost/regex.hpp>
+
+#include "regex_engine.h"
+#include "build_config.h"
+
+#if defined(HAVE_RE2)
+#include <re2/re2.h>
+#endif /* defined(HAVE_RE2) */
+
+#if defined(HAVE_PCRE2)
+#define PCRE2_CODE_UNIT_WIDTH 8
+#include <pcre2.h>
+#endif /* defined(HAVE_PCRE2) */
+
+std::string swd::regex_engine::default_type_ = "boost";
+
+namespace {
+    class boost_engine : public swd::regex_engine {
+        public:
+            boost_engine(const std::string& regex, bool icase) :
+             regex_(regex, (icase ? boost::regex::icase | boost::regex::mod_s : boost::regex::mod_s)) {
+            }
+
+            bool search(const std::string& input, std::size_t begin,
+             std::size_t end) const override {
+                boost::match_flag_type flags = boost::match_default;
+
+                if (begin > 0) {
+                    flags |= boost::match_prev_avail;
+                }
+
+                if (end < input.length()) {
+                    flags |= boost::match_not_eol | boost::match_not_eob;
+                }
+
+                /**
+                 * The base keeps buffer anchors like \A at the real start of the input. If
+                 * there is catastrophic backtracking boost throws an exception.
+                 */
+                boost::match_results<std::string::const_iterator> match;
+
+                return boost::regex_search(input.begin() + begin, input.begin() + end, match,
+                 regex_, flags, input.begin());
+            }
+
+        private:
+            boost::regex regex_;
+    };
+
+#if defined(HAVE_RE2)
+    class re2_engine : public swd::regex_engine {
+        public:
+            re2_engine(const std::string& regex, bool icase) :
+             regex_("(?m)" + regex, options(icase)) {
+                if (!regex_.ok()) {
+                    throw std::runtime_error(regex_.error());
+                }
+            }
+
+            bool search(const std::string& input, std::size_t begin,
+             std::size_t end) const override {
+                return regex_.Match(input, begin, end, RE2::UNANCHORED, nullptr, 0);
+            }
+
+        private:
+            static RE2::Options options(bool icase) {
+                /* Values are matched byte by byte like boost does it. */
+                RE2::Options options;
+                options.set_encoding(RE2::Options::EncodingLatin1);
+                options.set_case_sensitive(!icase);
+                options.set_dot_nl(true);
+                options.set_never_capture(true);
+                options.set_log_errors(false);
+
+                return options;
+            }
+
+            RE2 regex_;
+    };
+#endif /* defined(HAVE_RE2) */
+
+#if defined(HAVE_PCRE2)
+    /**
+     * Match data and JIT stacks must not be shared between threads, so every
+     * thread gets its own. One ovector pair is enough to tell if there is a match.
+     */
+    struct pcre2_thread_state {
+        pcre2_thread_state() :
+         match_data(pcre2_match_data_create(1, nullptr)),
+         context(pcre2_match_context_create(nullptr)),
+         stack(pcre2_jit_stack_create(32 * 1024, 512 * 1024, nullptr)) {
+            pcre2_jit_stack_assign(context, nullptr, stack);
+        }
+
+        ~pcre2_thread_state() {
+            pcre2_jit_stack_free(stack);
+            pcre2_match_context_free(context);
+            pcre2_match_data_free(match_data);
+        }
+
+        pcre2_match_data *match_data;
+        pcre2_match_context *context;
+        pcre2_jit_stack *stack;
+    };
+
+    class pcre2_engine : public swd::regex_engine {
+        public:
+            pcre2_engine(const std::string& regex, bool icase) {
+                int error;
+                PCRE2_SIZE offset;
+
+                code_ = pcre2_compile(reinterpret_cast<PCRE2_SPTR>(regex.data()),
+                 regex.length(), (icase ? PCRE2_CASELESS : 0) | PCRE2_DOTALL | PCRE2_MULTILINE,
+                 &error, &offset, nullptr);
+
+                if (!code_) {
+                    PCRE2_UCHAR message[256];
+                    pcre2_get_error_message(error, message, sizeof(message));
+
+                    throw std::runtime_error(reinterpret_cast<char *>(message));
+                }
+
+                /* Without JIT support the interpreter is used. */
+                pcre2_jit_compile(code_, PCRE2_JIT_COMPLETE);
+            }
+
+            ~pcre2_engine() override {
+                pcre2_code_free(code_);
+            }
+
+            pcre2_engine(const pcre2_engine&) = delete;
+            pcre2_engine& operator=(const pcre2_engine&) = delete;
+
+            bool search(const std::string& input, std::size_t begin,
+             std::size_t end) const override {
+                thread_local pcre2_thread_state state;
+
+                /* The subject ends with the window, lookbehinds still see the characters before it. */
+                int result = pcre2_match(code_, reinterpret_cast<PCRE2_SPTR>(input.data()),
+                 end, begin, (end < input.length() ? PCRE2_NOTEOL : 0), state.match_data,
+                 state.context);
+
+                /* Zero means that the ovector is too small, but there is a match. */
+                if (result >= 0) {
+                    return true;
+                } else if (result == PCRE2_ERROR_NOMATCH) {
+                    return false;
+                }
+
+                /* Match and stack limits are handled like catastrophic backtracking in boost. */
+                throw std::runtime_error("pcre2 match error " + std::to_string(result));
+            }
+
+        private:
+            pcre2_code *code_;
+    };
+#endif /* defined(HAVE_PCRE2) */
+}
+
+bool swd::regex_engine::search(const std::string& input) const {
+    return search(input, 0, input.length());
+}
+
+swd::regex_engine_ptr swd::regex_engine::compile(const std::string& regex, bool icase) {
+    if (default_type_ != "boost") {
+        try {
+            return compile(default_type_, regex, icase);
+        } catch (const std::runtime_error& e) {
+            /* Filters the default engine does not support are still matched by boost. */
+        }
+    }
+
+    return compile("boost", regex, icase);
+}
+
+swd::regex_engine_ptr swd::regex_engine::compile(const std::string& type,
+ const std::string& regex, bool icase) {
+    if (type == "boost") {
+        return boost::make_shared<const boost_engine>(regex, icase);
+    }
+
+#if defined(HAVE_RE2)
+    if (type == "re2") {
+        return boost::make_shared<const re2_engine>(regex, icase);
+    }
+#endif /* defined(HAVE_RE2) */
+
+#if defined(HAVE_PCRE2)
+    if (type == "pcre2") {
+        return boost::make_shared<const pcre2_engine>(regex, icase);
+    }
+#endif /* defined(HAVE_PCRE2) */
+
+    throw std::runtime_error("regex engine " + type + " is not available");
+}
+
+void swd::regex_engine::set_default_type(const std::string& type) {
+    default_type_ = type;
+}
+
+const std::string& swd::regex_engine::get_default_type() {
+    return default_type_;
+}
+
+std::vector<std::string> swd::regex_engine::get_types() {
+    std::vector<std::string> types = {"boost"};
+
+#if defined(HAVE_RE2)
+    types.push_back("re2");
+#endif /* defined(HAVE_RE2) */
+
+#if defined(HAVE_PCRE2)
+    types.push_back("pcre2");
+#endif /* defined(HAVE_PCRE2) */
+
+    return types;
+}
+
+bool swd::regex_engine::is_available(const std::string& type) {
+    for (const auto& available: get_types()) {
+        if (type == available) {
+            return true;
+        }
+    }
+
+    return false;
+}
@@ -43,7 +43,7 @@ void swd::reply::set_message(const std::string& message) {
     message_ = message;
 }
 
-std::string swd::reply::get_message() const {
+const std::string& swd::reply::get_message() const {
     return message_;
 }
 
@@ -51,20 +51,52 @@ void swd::reply::set_threats(const std::vector<std::string>& threats) {
     threats_ = threats;
 }
 
-std::vector<std::string> swd::reply::get_threats() const {
+const std::vector<std::string>& swd::reply::get_threats() const {
     return threats_;
 }
 
-void swd::reply::set_content(const std::string& content) {
-    content_ = content;
+void swd::reply::clear_content() {
+    buffer_.clear();
+    segments_.clear();
+}
+
+std::string& swd::reply::get_buffer() {
+    return buffer_;
+}
+
+void swd::reply::add_segment(const char* data, std::size_t length) {
+    segments_.push_back({data, 0, length});
+}
+
+void swd::reply::add_buffer_segment(std::size_t offset, std::size_t length) {
+    segments_.push_back({nullptr, offset, length});
 }
 
 std::string swd::reply::get_content() const {
-    return content_;
+    std::string content;
+
+    for (const auto& segment: segments_) {
+        if (segment.data) {
+            content.append(segment.data, segment.length);
+        } else {
+            content.append(buffer_, segment.offset, segment.length);
+        }
+    }
+
+    return content;
 }
 
-std::vector<boost::asio::const_buffer> swd::reply::to_buffers() const {
-    std::vector<boost::asio::const_buffer> buffers;
-    buffers.push_back(boost::asio::buffer(content_));
-    return buffers;
+const std::vector<boost::asio::const_buffer>& swd::reply::to_buffers() {
+    /* The buffer is complete now, so the offsets can be resolved. */
+    buffers_.clear();
+
+    for (const auto& segment: segments_) {
+        if (segment.data) {
+            buffers_.push_back(boost::asio::buffer(segment.data, segment.length));
+        } else {
+            buffers_.push_back(boost::asio::buffer(buffer_.data() + segment.offset, segment.length));
+        }
+    }
+
+    return buffers_;
 }
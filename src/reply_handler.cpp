@@ -29,42 +29,141 @@
  * files in the program, then also delete it here.
  */
 
-#include <json/json.h>
+#include <charconv>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "reply_handler.h"
-#include "log.h"
+
+namespace {
+    /**
+     * Replies without message and threats are by far the most common ones, so
+     * they are prebuilt for every status code.
+     */
+    const std::string status_frames[] = {
+        "",
+        "{\"status\":1,\"threats\":[]}\n",
+        "{\"status\":2,\"threats\":[]}\n",
+        "{\"status\":3,\"threats\":[]}\n",
+        "{\"status\":4,\"threats\":[]}\n",
+        "{\"status\":5,\"threats\":[]}\n",
+        "{\"status\":6,\"threats\":[]}\n",
+        "{\"status\":7,\"threats\":[]}\n"
+    };
+
+    const char quote[] = "\"";
+    const char separator[] = ",";
+    const char threats_end[] = "]}\n";
+}
 
 swd::reply_handler::reply_handler(swd::reply_ptr reply) :
  reply_(std::move(reply)) {
 }
 
 bool swd::reply_handler::encode() const {
-    try {
-        Json::Value root;
-        Json::FastWriter writer;
+    reply_->clear_content();
 
-        root["status"] = reply_->get_status();
+    int status = reply_->get_status();
+    const std::string& message = reply_->get_message();
+    const std::vector<std::string>& threats = reply_->get_threats();
 
-        std::string message = reply_->get_message();
-        if (!message.empty()) {
-            root["message"] = message;
-        }
+    if (message.empty() && threats.empty() && (status >= STATUS_OK) &&
+     (status <= STATUS_OVERLOADED)) {
+        reply_->add_segment(status_frames[status].data(), status_frames[status].size());
+        return true;
+    }
+
+    /* The keys are written in the same order as jsoncpp writes them. */
+    std::string& buffer = reply_->get_buffer();
+    buffer += '{';
 
-        std::vector<std::string> threats = reply_->get_threats();
-        Json::Value output(Json::arrayValue);
-        for (const auto& threat: threats) {
-            output.append(threat);
+    if (!message.empty()) {
+        buffer += "\"message\":";
+        append_quoted(buffer, message);
+        buffer += ',';
+    }
+
+    char digits[16];
+    char* digits_end = std::to_chars(digits, digits + sizeof(digits), status).ptr;
+
+    buffer += "\"status\":";
+    buffer.append(digits, digits_end);
+    buffer += ",\"threats\":[";
+    reply_->add_buffer_segment(0, buffer.size());
+
+    /* Threat paths are sent from the reply itself if they do not have to be escaped. */
+    for (std::size_t i = 0; i < threats.size(); i++) {
+        const std::string& threat = threats[i];
+
+        if (i > 0) {
+            reply_->add_segment(separator, 1);
         }
-        root["threats"] = output;
 
-        reply_->set_content(writer.write(root));
-    } catch (...) {
-        swd::log::i()->send(swd::uncritical_error, "Uncaught json encode exception");
-        return false;
+        if (needs_escaping(threat)) {
+            std::size_t offset = buffer.size();
+            append_quoted(buffer, threat);
+            reply_->add_buffer_segment(offset, buffer.size() - offset);
+        } else {
+            reply_->add_segment(quote, 1);
+            reply_->add_segment(threat.data(), threat.size());
+            reply_->add_segment(quote, 1);
+        }
     }
 
+    reply_->add_segment(threats_end, 3);
+
     return true;
 }
+
+bool swd::reply_handler::needs_escaping(const std::string& input) {
+    for (char c: input) {
+        if ((c == '"') || (c == '\\') || (static_cast<unsigned char>(c) < 0x20)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void swd::reply_handler::append_quoted(std::string& output, const std::string& input) {
+    static const char hex[] = "0123456789ABCDEF";
+
+    output += '"';
+
+    for (char c: input) {
+        switch (c) {
+            case '"':
+                output += "\\\"";
+                break;
+            case '\\':
+                output += "\\\\";
+                break;
+            case '\b':
+                output += "\\b";
+                break;
+            case '\f':
+                output += "\\f";
+                break;
+            case '\n':
+                output += "\\n";
+                break;
+            case '\r':
+                output += "\\r";
+                break;
+            case '\t':
+                output += "\\t";
+                break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    output += "\\u00";
+                    output += hex[(c >> 4) & 0xF];
+                    output += hex[c & 0xF];
+                } else {
+                    output += c;
+                }
+        }
+    }
+
+    output += '"';
+}
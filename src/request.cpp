@@ -31,6 +31,8 @@
 
 #include <algorithm>
 #include <sstream>
+#include <utility>
+#include <boost/make_shared.hpp>
 
 #include "request.h"
 
@@ -48,43 +50,80 @@ void swd::request::add_parameter(const swd::parameter_ptr& parameter) {
 
 void swd::request::add_parameter(const std::string& path,
  const std::string& value) {
-    swd::parameter_ptr parameter(new swd::parameter);
+    swd::parameter_ptr parameter = boost::allocate_shared<swd::parameter>(
+        std::pmr::polymorphic_allocator<swd::parameter>(&arena_)
+    );
     parameter->set_path(path);
     parameter->set_value(value);
 
     parameters_.push_back(parameter);
 }
 
+void swd::request::clear_parameters() {
+    parameters_.clear();
+}
+
 const swd::parameters& swd::request::get_parameters() const {
     return parameters_;
 }
 
-void swd::request::append_content(const char& input) {
-    content_.push_back(input);
+void swd::request::append_content(const char* begin, const char* end) {
+    content_.append(begin, end);
+
+    if (hmac_) {
+        hmac_->Update((const unsigned char *)begin, end - begin);
+    }
+}
+
+void swd::request::start_hmac(const swd::hmac& keyed_hmac, const std::string& key) {
+    hmac_ = std::make_unique<swd::hmac>(keyed_hmac);
+    hmac_key_ = key;
+
+    hmac_->Update((const unsigned char *)content_.data(), content_.size());
+}
+
+bool swd::request::has_hmac(const std::string& key) const {
+    return (hmac_ && (hmac_key_ == key));
+}
+
+bool swd::request::verify_hmac(const unsigned char* mac) {
+    return hmac_->Verify(mac);
 }
 
 void swd::request::set_content(const std::string& content) {
     content_ = content;
 }
 
-std::string swd::request::get_content() const {
+void swd::request::set_content(std::string&& content) {
+    content_ = std::move(content);
+}
+
+void swd::request::set_compressed(bool compressed) {
+    compressed_ = compressed;
+}
+
+bool swd::request::is_compressed() const {
+    return compressed_;
+}
+
+const std::string& swd::request::get_content() const {
     return content_;
 }
 
-void swd::request::append_signature(const char& input) {
-    signature_.push_back(input);
+void swd::request::append_signature(const char* begin, const char* end) {
+    signature_.append(begin, end);
 }
 
 void swd::request::set_signature(const std::string& signature) {
     signature_ = signature;
 }
 
-std::string swd::request::get_signature() const {
+const std::string& swd::request::get_signature() const {
     return signature_;
 }
 
-void swd::request::append_profile_id(const char& input) {
-    profile_id_.push_back(input);
+void swd::request::append_profile_id(const char* begin, const char* end) {
+    profile_id_.append(begin, end);
 }
 
 void swd::request::set_profile_id(const unsigned long long& profile_id) {
@@ -101,7 +140,7 @@ void swd::request::set_client_ip(const std::string& client_ip) {
     client_ip_ = client_ip;
 }
 
-std::string swd::request::get_client_ip() const {
+const std::string& swd::request::get_client_ip() const {
     return client_ip_;
 }
 
@@ -109,7 +148,7 @@ void swd::request::set_caller(const std::string& caller) {
     caller_ = caller;
 }
 
-std::string swd::request::get_caller() const {
+const std::string& swd::request::get_caller() const {
     return caller_;
 }
 
@@ -117,7 +156,7 @@ void swd::request::set_resource(const std::string& resource) {
     resource_ = resource;
 }
 
-std::string swd::request::get_resource() const {
+const std::string& swd::request::get_resource() const {
     return resource_;
 }
 
@@ -139,13 +178,19 @@ int swd::request::get_total_integrity_rules() const {
 
 void swd::request::add_hash(const std::string& algorithm,
  const std::string& digest) {
-    swd::hash_ptr hash(new swd::hash);
+    swd::hash_ptr hash = boost::allocate_shared<swd::hash>(
+        std::pmr::polymorphic_allocator<swd::hash>(&arena_)
+    );
     hash->set_algorithm(algorithm);
     hash->set_digest(digest);
 
     hashes_[algorithm] = hash;
 }
 
+void swd::request::clear_hashes() {
+    hashes_.clear();
+}
+
 const swd::hashes& swd::request::get_hashes() const {
     return hashes_;
 }
@@ -29,11 +29,10 @@
  * files in the program, then also delete it here.
  */
 
-#include <cryptopp/hmac.h>
-#include <cryptopp/sha.h>
-#include <cryptopp/hex.h>
-#include <json/json.h>
+#include <algorithm>
+#include <boost/make_shared.hpp>
 #include <utility>
+#include <zlib.h>
 
 #include "request_handler.h"
 #include "blacklist.h"
@@ -41,6 +40,7 @@
 #include "integrity.h"
 #include "storage.h"
 #include "log.h"
+#include "json_decoder.h"
 
 swd::request_handler::request_handler(swd::request_ptr request,
  swd::cache_ptr cache, swd::storage_ptr storage) :
@@ -50,134 +50,194 @@ swd::request_handler::request_handler(swd::request_ptr request,
 }
 
 bool swd::request_handler::valid_signature() const {
-    try {
-        /* Prepare secret key for hmac. */
-        std::string key = request_->get_profile()->get_key();
+    swd::profile_ptr profile = request_->get_profile();
+    const std::string& key = profile->get_key();
+
+    /* Transform user mac from hex to binary. */
+    byte user_mac[swd::hmac::DIGESTSIZE];
+
+    if (!decode_hex(request_->get_signature(), user_mac, sizeof(user_mac))) {
+        return false;
+    }
+
+    /**
+     * The connection might have hashed the content already while it was read.
+     * That is only possible if the cached key is still the key of the profile.
+     */
+    if (request_->has_hmac(key)) {
+        return request_->verify_hmac(user_mac);
+    }
+
+    /* The key schedule is cached per profile, so only a copy is required here. */
+    swd::hmac_ptr keyed_hmac;
 
-        CryptoPP::HMAC<CryptoPP::SHA256> hmac(
-            (const byte *)key.c_str(),
+    if (cache_) {
+        keyed_hmac = cache_->get_hmac(profile->get_id(), key);
+    } else {
+        keyed_hmac = boost::make_shared<const swd::hmac>(
+            (const byte *)key.data(),
             key.size()
         );
+    }
 
-        /* Transform user mac from lower case hex to binary. */
-        std::string user_mac;
+    /* Calculate the mac directly over the content and compare it in constant time. */
+    swd::hmac hmac(*keyed_hmac);
 
-        CryptoPP::StringSource(
-            request_->get_signature(),
-            true, /* pumpAll */
-            new CryptoPP::HexDecoder(
-                new CryptoPP::StringSink(user_mac)
-            )
-        );
+    const std::string& content = request_->get_content();
+    hmac.Update((const byte *)content.data(), content.size());
 
-        /* Compare given mac with expected mac. */
-        bool result = false;
-
-        CryptoPP::StringSource ss(
-            request_->get_content() + user_mac,
-            true, /* pumpAll */
-            new CryptoPP::HashVerificationFilter(
-                hmac,
-                new CryptoPP::ArraySink((byte*)&result, sizeof(result)),
-                CryptoPP::HashVerificationFilter::PUT_RESULT |
-                CryptoPP::HashVerificationFilter::HASH_AT_END
-            )
-        );
+    return hmac.Verify(user_mac);
+}
 
-        return result;
-    } catch (const CryptoPP::Exception& e) {
-        /* Something went wrong, so the authentication was not successful. */
+bool swd::request_handler::decode_hex(const std::string& input,
+ unsigned char* output, std::size_t length) {
+    if (input.length() != (length * 2)) {
         return false;
     }
-}
 
-bool swd::request_handler::decode() const {
-    /**
-     * The daemon could crash if the json string is somehow invalid, so it is a
-     * very good idea to catch exceptions.
-     */
-    try {
-        Json::Value root;
-        Json::Reader reader;
-
-        if (!reader.parse(request_->get_content(), root)) {
+    for (std::size_t i = 0; i < input.length(); i++) {
+        char c = input[i];
+        unsigned char value;
+
+        if ((c >= '0') && (c <= '9')) {
+            value = (c - '0');
+        } else if ((c >= 'a') && (c <= 'f')) {
+            value = (c - 'a' + 10);
+        } else if ((c >= 'A') && (c <= 'F')) {
+            value = (c - 'A' + 10);
+        } else {
             return false;
         }
 
-        /* If root is not an object the input is invalid. */
-        if (!root.isObject()) {
-            return false;
+        if ((i % 2) == 0) {
+            output[i / 2] = (value << 4);
+        } else {
+            output[i / 2] |= value;
         }
+    }
 
-        /* First we set the client ip. It shouldn't be possible that this is empty. */
-        Json::Value client_ip = root["client_ip"];
+    return true;
+}
 
-        if (!client_ip) {
-            return false;
-        }
+void swd::request_handler::set_limits(int max_parameters, int max_length_path,
+ int max_length_value, int max_length_inflated) {
+    max_parameters_ = max_parameters;
+    max_length_path_ = max_length_path;
+    max_length_value_ = max_length_value;
+    max_length_inflated_ = max_length_inflated;
+}
 
-        request_->set_client_ip(client_ip.asString());
+void swd::request_handler::set_full_scan(bool full_scan) {
+    full_scan_ = full_scan;
+}
 
-        /* The target script on the observed system. Should not be empty but might in rare cases. */
-        Json::Value caller = root["caller"];
+void swd::request_handler::set_scan_window(int scan_window, int unbounded_span) {
+    scan_window_ = scan_window;
+    unbounded_span_ = unbounded_span;
+}
 
-        if (!caller) {
-            caller = "";
+void swd::request_handler::set_scan_pool(swd::scan_pool_ptr scan_pool) {
+    scan_pool_ = std::move(scan_pool);
+}
+
+int swd::request_handler::decode() {
+    /* The signature covers the compressed content, so it is inflated only now. */
+    if (request_->is_compressed()) {
+        int status = inflate();
+
+        if (status != STATUS_OK) {
+            return status;
         }
+    }
 
-        request_->set_caller(caller.asString());
+    swd::json_decoder json_decoder(
+        request_,
+        max_parameters_,
+        max_length_path_,
+        max_length_value_
+    );
 
-        /* For backwards compatibility it is acceptable that the resource is empty. */
-        Json::Value resource = root["resource"];
+    int status = json_decoder.decode(request_->get_content());
 
-        if (!resource) {
-            resource = "";
-        }
+    /* Nested values do not invalidate the request, but the client should know about them. */
+    const std::vector<std::string>& skipped = json_decoder.get_skipped();
 
-        request_->set_resource(resource.asString());
+    if (!skipped.empty()) {
+        swd::log::i()->send(swd::uncritical_error, "Skipped " + std::to_string(skipped.size())
+         + " nested input values or hashes, e.g. " + skipped.front());
+    }
 
-        /* Even if there is no user input there should be at least an empty array. */
-        Json::Value input = root["input"];
+    /* The limits are checked while decoding, so that big requests are not decoded completely. */
+    if (status == STATUS_BAD_REQUEST) {
+        message_ = json_decoder.get_message();
+    }
 
-        if (!input) {
-            return false;
-        }
+    return status;
+}
 
-        /* Iterate over the input and add it to the request as parameters. */
-        for (auto it_parameter = input.begin(); it_parameter != input.end(); it_parameter++) {
-            try {
-                request_->add_parameter(
-                    it_parameter.key().asString(),
-                    (*it_parameter).asString()
-                );
-            } catch (const std::runtime_error& e) {
-                swd::log::i()->send(swd::uncritical_error, e.what());
-            }
-        }
+int swd::request_handler::inflate() {
+    const std::string& content = request_->get_content();
 
-        /* Iterate over the hashes and add them to the request. */
-        Json::Value hashes = root["hashes"];
+    z_stream stream = {};
 
-        if (!hashes) {
-            return false;
-        }
+    /* Deflate streams with zlib and with gzip headers are accepted. */
+    if (inflateInit2(&stream, 15 + 32) != Z_OK) {
+        message_ = "Unable to inflate content";
+        return STATUS_BAD_REQUEST;
+    }
+
+    stream.next_in = (Bytef *)content.data();
+    stream.avail_in = content.size();
+
+    std::string inflated;
+    int result = Z_OK;
+
+    while (result == Z_OK) {
+        if (stream.total_out == inflated.size()) {
+            /* One byte more than allowed is enough to detect decompression bombs. */
+            if ((max_length_inflated_ > -1) && (inflated.size() > (std::size_t)max_length_inflated_)) {
+                break;
+            }
 
-        for (auto it_hash = hashes.begin(); it_hash != hashes.end(); it_hash++) {
-            try {
-                request_->add_hash(
-                    it_hash.key().asString(),
-                    (*it_hash).asString()
-                );
-            } catch (const std::runtime_error& e) {
-                swd::log::i()->send(swd::uncritical_error, e.what());
+            std::size_t size = std::max<std::size_t>(inflated.size() * 2, (content.size() * 4) + 1024);
+
+            if (max_length_inflated_ > -1) {
+                size = std::min<std::size_t>(size, (std::size_t)max_length_inflated_ + 1);
             }
+
+            inflated.resize(size);
         }
-    } catch (...) {
-        swd::log::i()->send(swd::uncritical_error, "Uncaught json decode exception");
-        return false;
+
+        stream.next_out = (Bytef *)&inflated[stream.total_out];
+        stream.avail_out = inflated.size() - stream.total_out;
+
+        result = ::inflate(&stream, Z_NO_FLUSH);
     }
 
-    return true;
+    std::size_t length = stream.total_out;
+    bool trailing = (stream.avail_in > 0);
+
+    inflateEnd(&stream);
+
+    /* A stream can also end with exactly the one byte too much. */
+    if ((result == Z_OK) || ((max_length_inflated_ > -1) && (length > (std::size_t)max_length_inflated_))) {
+        message_ = "Too long inflated content";
+        return STATUS_BAD_REQUEST;
+    }
+
+    if ((result != Z_STREAM_END) || trailing) {
+        return STATUS_BAD_JSON;
+    }
+
+    inflated.resize(length);
+    request_->set_content(std::move(inflated));
+    request_->set_compressed(false);
+
+    return STATUS_OK;
+}
+
+const std::string& swd::request_handler::get_message() const {
+    return message_;
 }
 
 void swd::request_handler::process() const {
@@ -190,12 +250,12 @@ void swd::request_handler::process() const {
     }
 
     if (profile->is_blacklist_enabled()) {
-        swd::blacklist blacklist(cache_);
+        swd::blacklist blacklist(cache_, full_scan_, scan_pool_, scan_window_, unbounded_span_);
         blacklist.scan(request_);
     }
 
     if (profile->is_whitelist_enabled()) {
-        swd::whitelist whitelist(cache_);
+        swd::whitelist whitelist(cache_, scan_pool_);
         whitelist.scan(request_);
     }
 
@@ -213,7 +273,7 @@ void swd::request_handler::process() const {
 std::vector<std::string> swd::request_handler::get_threats() const {
     std::vector<std::string> threats;
 
-    swd::parameters parameters = request_->get_parameters();
+    const swd::parameters& parameters = request_->get_parameters();
 
     for (const auto& parameter: parameters) {
         if (parameter->is_threat()) {
@@ -29,45 +29,168 @@
  * files in the program, then also delete it here.
  */
 
-#include <cctype>
+#include <algorithm>
+#include <cstring>
 
 #include "request_parser.h"
 
+/**
+ * Longer (or empty) profile ids do not fit into an unsigned long long in every
+ * case and would throw when they get converted.
+ */
+#define MAX_PROFILE_ID_LENGTH 19
+
+/* Signatures are hex encoded hmac-sha256 digests. */
+#define MAX_SIGNATURE_LENGTH 64
+
+/* The length of compressed content is limited to less than 1 GB. */
+#define MAX_CONTENT_LENGTH_DIGITS 9
+
 swd::request_parser::request_parser() :
  state_(profile) {
 }
 
-boost::tribool swd::request_parser::consume(const swd::request_ptr& request,
- const char& input) {
-    switch (state_) {
-        case profile:
-            if (input == '\n') {
-                state_ = signature;
-                return boost::indeterminate;
-            } else if (isdigit(input)) {
-                request->append_profile_id(input);
-                return boost::indeterminate;
-            } else {
-                return false;
+boost::tuple<boost::tribool, const char*> swd::request_parser::parse(
+ const swd::request_ptr& request, const char* begin, const char* end) {
+    while (begin != end) {
+        /* Compressed content has a fixed length and might contain line ends. */
+        if (state_ == compressed_content) {
+            std::size_t length = std::min<std::size_t>(content_remaining_, end - begin);
+
+            request->append_content(begin, begin + length);
+            content_remaining_ -= length;
+            begin += length;
+
+            if (content_remaining_ == 0) {
+                state_ = content_end;
             }
-        case signature:
-            if (input == '\n') {
-                state_ = content;
-                return boost::indeterminate;
-            } else if (isalnum(input)) {
-                request->append_signature(input);
-                return boost::indeterminate;
-            } else {
-                return false;
+
+            continue;
+        }
+
+        if (state_ == content_end) {
+            if (*begin != '\n') {
+                return boost::make_tuple(boost::tribool(false), begin);
             }
-        case content:
-            if (input == '\n') {
-                return true;
-            } else {
-                request->append_content(input);
-                return boost::indeterminate;
+
+            return boost::make_tuple(boost::tribool(true), begin + 1);
+        }
+
+        /* Everything up to the next line end belongs to the current state. */
+        const char* newline = static_cast<const char*>(memchr(begin, '\n', end - begin));
+        const char* stop = (newline ? newline : end);
+
+        switch (state_) {
+            case profile: {
+                /* The profile id is optionally followed by the length of compressed content. */
+                const char* comma = static_cast<const char*>(memchr(begin, ',', stop - begin));
+                const char* id_end = (comma ? comma : stop);
+
+                profile_id_length_ += (id_end - begin);
+
+                if (!is_digits(begin, id_end) || (profile_id_length_ > MAX_PROFILE_ID_LENGTH)
+                 || ((newline || comma) && (profile_id_length_ == 0))) {
+                    return boost::make_tuple(boost::tribool(false), id_end);
+                }
+
+                request->append_profile_id(begin, id_end);
+
+                if (comma) {
+                    request->set_compressed(true);
+                    state_ = content_length;
+                    begin = comma + 1;
+                    continue;
+                }
+
+                if (newline) {
+                    state_ = signature;
+                }
+
+                break;
             }
-        default:
-            return false;
+            case content_length:
+                content_length_digits_ += (stop - begin);
+
+                if (!is_digits(begin, stop) || (content_length_digits_ > MAX_CONTENT_LENGTH_DIGITS)
+                 || (newline && (content_length_digits_ == 0))) {
+                    return boost::make_tuple(boost::tribool(false), stop);
+                }
+
+                for (const char* digit = begin; digit != stop; ++digit) {
+                    content_remaining_ = (content_remaining_ * 10) + (*digit - '0');
+                }
+
+                if (newline) {
+                    state_ = signature;
+                }
+
+                break;
+            case signature:
+                signature_length_ += (stop - begin);
+
+                if (!is_alnums(begin, stop) || (signature_length_ > MAX_SIGNATURE_LENGTH)) {
+                    return boost::make_tuple(boost::tribool(false), stop);
+                }
+
+                request->append_signature(begin, stop);
+
+                if (newline) {
+                    if (!request->is_compressed()) {
+                        state_ = content;
+                    } else if (content_remaining_ > 0) {
+                        state_ = compressed_content;
+                    } else {
+                        state_ = content_end;
+                    }
+                }
+
+                break;
+            case content:
+                request->append_content(begin, stop);
+
+                if (newline) {
+                    return boost::make_tuple(boost::tribool(true), newline + 1);
+                }
+
+                break;
+            default:
+                return boost::make_tuple(boost::tribool(false), begin);
+        }
+
+        /* The line is not complete yet, the rest follows with the next chunk. */
+        if (!newline) {
+            return boost::make_tuple(boost::tribool(boost::indeterminate), end);
+        }
+
+        begin = newline + 1;
+    }
+
+    return boost::make_tuple(boost::tribool(boost::indeterminate), begin);
+}
+
+bool swd::request_parser::has_profile_id() const {
+    return (state_ != profile);
+}
+
+bool swd::request_parser::is_digits(const char* begin, const char* end) {
+    /* Simple branch free loop, the compiler is able to vectorize it. */
+    bool valid = true;
+
+    for (; begin != end; ++begin) {
+        valid &= ((unsigned char)(*begin - '0') < 10);
     }
+
+    return valid;
+}
+
+bool swd::request_parser::is_alnums(const char* begin, const char* end) {
+    bool valid = true;
+
+    for (; begin != end; ++begin) {
+        unsigned char lower = (*begin | 0x20);
+
+        valid &= (((unsigned char)(*begin - '0') < 10) || ((unsigned char)(lower - 'a') < 26));
+    }
+
+    return valid;
 }
@@ -0,0 +1,425 @@
+/**
+ * Shadow Daemon -- Web Application Firewall
+ *
+ *   Copyright (C) 2014-2022 Hendrik Buchwald <hb@zecure.org>
+ *
+ * This file is part of Shadow Daemon. Shadow Daemon is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, version 2.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+
+#include "safe_chars.h"
+
+bool swd::safe_chars::contains_only(const char* begin, const char* end) {
+    bool valid = true;
+
+    for (; begin != end; ++begin) {
+        unsigned char c = *begin;
+        unsigned char lower = (c | 0x20);
+
+        valid &= (((unsigned char)(c - '0') < 10) | ((unsigned char)(lower - 'a') < 26) |
+         (c == '_') | (c == '-') | (c == '.'));
+    }
+
+    return valid;
+}
+
+bool swd::safe_chars::can_match(const std::string& regex) {
+    swd::safe_chars analyzer(regex);
+
+    bool result = analyzer.parse_alternation();
+
+    /* Everything that is not understood completely might match. */
+    if (!analyzer.valid_ || (analyzer.pos_ != regex.length())) {
+        return true;
+    }
+
+    return result;
+}
+
+swd::safe_chars::safe_chars(const std::string& regex) :
+ regex_(regex) {
+}
+
+bool swd::safe_chars::parse_alternation() {
+    bool result = parse_sequence();
+
+    while (valid_ && (pos_ < regex_.length()) && (regex_[pos_] == '|')) {
+        pos_++;
+        result |= parse_sequence();
+    }
+
+    return result;
+}
+
+bool swd::safe_chars::parse_sequence() {
+    bool result = true;
+
+    while (valid_ && (pos_ < regex_.length()) && (regex_[pos_] != '|') && (regex_[pos_] != ')')) {
+        bool atom = parse_atom();
+
+        /* An atom that is optional does not need any characters. */
+        if (parse_quantifier()) {
+            atom = true;
+        }
+
+        result &= atom;
+    }
+
+    return result;
+}
+
+bool swd::safe_chars::parse_atom() {
+    char c = regex_[pos_++];
+
+    switch (c) {
+        case '(':
+            return parse_group();
+        case '[':
+            return parse_class();
+        case '.':
+        case '^':
+        case '$':
+            return true;
+        case '\\': {
+            char_set set;
+
+            if (!parse_escape(set)) {
+                return true;
+            }
+
+            return (set & get_safe_set()).any();
+        }
+        case '*':
+        case '+':
+        case '?':
+        case '{':
+            /* A quantifier without atom is a syntax error, except for a literal brace. */
+            if (c != '{') {
+                valid_ = false;
+            }
+
+            return get_safe_set().test((unsigned char)c);
+        default:
+            return get_safe_set().test((unsigned char)c);
+    }
+}
+
+bool swd::safe_chars::parse_group() {
+    bool zero_width = false;
+
+    if ((pos_ < regex_.length()) && (regex_[pos_] == '?')) {
+        pos_++;
+
+        if (pos_ >= regex_.length()) {
+            valid_ = false;
+            return true;
+        }
+
+        char c = regex_[pos_];
+
+        if (c == ':') {
+            pos_++;
+        } else if ((c == '=') || (c == '!')) {
+            pos_++;
+            zero_width = true;
+        } else if ((c == '<') && (pos_ + 1 < regex_.length()) &&
+         ((regex_[pos_ + 1] == '=') || (regex_[pos_ + 1] == '!'))) {
+            pos_ += 2;
+            zero_width = true;
+        } else {
+            /* Inline modifiers like (?i) or (?i:...), others like (?x) change the syntax. */
+            while ((pos_ < regex_.length()) &&
+             (isalpha((unsigned char)regex_[pos_]) || (regex_[pos_] == '-'))) {
+                if (!strchr("ims-", regex_[pos_])) {
+                    valid_ = false;
+                    return true;
+                }
+
+                pos_++;
+            }
+
+            if (pos_ >= regex_.length()) {
+                valid_ = false;
+                return true;
+            }
+
+            if (regex_[pos_] == ')') {
+                pos_++;
+                return true;
+            }
+
+            if (regex_[pos_] != ':') {
+                valid_ = false;
+                return true;
+            }
+
+            pos_++;
+        }
+    }
+
+    bool result = parse_alternation();
+
+    if ((pos_ >= regex_.length()) || (regex_[pos_] != ')')) {
+        valid_ = false;
+        return true;
+    }
+
+    pos_++;
+
+    /* Assertions do not consume characters. */
+    return (zero_width || result);
+}
+
+bool swd::safe_chars::parse_class() {
+    char_set set;
+    bool negated = false;
+    bool first = true;
+
+    if ((pos_ < regex_.length()) && (regex_[pos_] == '^')) {
+        negated = true;
+        pos_++;
+    }
+
+    while (pos_ < regex_.length()) {
+        char c = regex_[pos_];
+
+        /* A closing bracket at the beginning is a literal. */
+        if ((c == ']') && !first) {
+            pos_++;
+            return (negated ? (~set & get_safe_set()).any() : (set & get_safe_set()).any());
+        }
+
+        first = false;
+        pos_++;
+
+        /* Named classes like [:alpha:], equivalence classes and collating elements are not analyzed. */
+        if ((c == '[') && (pos_ < regex_.length()) && strchr(":=.", regex_[pos_])) {
+            valid_ = false;
+            return true;
+        }
+
+        if (c == '\\') {
+            char_set escaped;
+
+            if (!parse_escape(escaped) || (escaped.count() != 1)) {
+                set |= escaped;
+                continue;
+            }
+
+            /* A single escaped character might start a range. */
+            for (std::size_t i = 0; i < 256; i++) {
+                if (escaped.test(i)) {
+                    c = (char)i;
+                }
+            }
+        }
+
+        if ((pos_ + 1 < regex_.length()) && (regex_[pos_] == '-') && (regex_[pos_ + 1] != ']')) {
+            pos_++;
+
+            unsigned char last = regex_[pos_++];
+
+            if (last == '\\') {
+                char_set escaped;
+
+                if (!parse_escape(escaped) || (escaped.count() != 1)) {
+                    valid_ = false;
+                    return true;
+                }
+
+                for (std::size_t i = 0; i < 256; i++) {
+                    if (escaped.test(i)) {
+                        last = (unsigned char)i;
+                    }
+                }
+            }
+
+            for (unsigned int i = (unsigned char)c; i <= last; i++) {
+                set.set(i);
+            }
+        } else {
+            set.set((unsigned char)c);
+        }
+    }
+
+    valid_ = false;
+    return true;
+}
+
+bool swd::safe_chars::parse_escape(char_set& set) {
+    if (pos_ >= regex_.length()) {
+        valid_ = false;
+        return false;
+    }
+
+    char c = regex_[pos_++];
+
+    switch (c) {
+        case 'b':
+        case 'B':
+        case 'A':
+        case 'z':
+        case 'Z':
+        case 'G':
+        case '<':
+        case '>':
+            return false;
+        case 'd':
+        case 'w':
+        case 's':
+            add_shorthand(c, set);
+            return true;
+        case 'D':
+        case 'W':
+        case 'S': {
+            /* Negated shorthands match everything that the lowercase version does not match. */
+            char_set positive;
+            add_shorthand(tolower(c), positive);
+
+            set |= ~positive;
+            return true;
+        }
+        case 'n':
+            set.set('\n');
+            return true;
+        case 't':
+            set.set('\t');
+            return true;
+        case 'r':
+            set.set('\r');
+            return true;
+        case 'f':
+            set.set('\f');
+            return true;
+        case 'v':
+            set.set('\v');
+            return true;
+        case 'x': {
+            std::size_t length = 0;
+
+            while ((length < 2) && (pos_ + length < regex_.length()) &&
+             isxdigit((unsigned char)regex_[pos_ + length])) {
+                length++;
+            }
+
+            if (length == 0) {
+                valid_ = false;
+                return false;
+            }
+
+            set.set(strtoul(regex_.substr(pos_, length).c_str(), nullptr, 16));
+            pos_ += length;
+            return true;
+        }
+        default:
+            /* Back references, unicode properties and similar are not analyzed. */
+            if (isalnum((unsigned char)c)) {
+                valid_ = false;
+                return false;
+            }
+
+            set.set((unsigned char)c);
+            return true;
+    }
+}
+
+void swd::safe_chars::add_shorthand(char c, char_set& set) {
+    for (std::size_t i = 0; i < 256; i++) {
+        if (c == 'd') {
+            set.set(i, set.test(i) || isdigit(i));
+        } else if (c == 'w') {
+            set.set(i, set.test(i) || isalnum(i) || (i == '_'));
+        } else if (c == 's') {
+            set.set(i, set.test(i) || isspace(i));
+        }
+    }
+}
+
+bool swd::safe_chars::parse_quantifier() {
+    if (pos_ >= regex_.length()) {
+        return false;
+    }
+
+    bool optional = false;
+    char c = regex_[pos_];
+
+    if ((c == '*') || (c == '?')) {
+        optional = true;
+        pos_++;
+    } else if (c == '+') {
+        pos_++;
+    } else if (c == '{') {
+        std::size_t end = pos_ + 1;
+
+        while ((end < regex_.length()) && isdigit((unsigned char)regex_[end])) {
+            end++;
+        }
+
+        /* Without a number the brace is a literal. */
+        if (end == (pos_ + 1)) {
+            return false;
+        }
+
+        optional = (strtoul(regex_.substr(pos_ + 1, end - pos_ - 1).c_str(), nullptr, 10) == 0);
+
+        while ((end < regex_.length()) && (regex_[end] != '}')) {
+            end++;
+        }
+
+        if (end >= regex_.length()) {
+            valid_ = false;
+            return true;
+        }
+
+        pos_ = end + 1;
+    } else {
+        return false;
+    }
+
+    /* Lazy and possessive modifiers. */
+    if ((pos_ < regex_.length()) && ((regex_[pos_] == '?') || (regex_[pos_] == '+'))) {
+        pos_++;
+    }
+
+    return optional;
+}
+
+const swd::safe_chars::char_set& swd::safe_chars::get_safe_set() {
+    static const char_set safe_set = [] {
+        char_set set;
+
+        for (std::size_t i = 0; i < 256; i++) {
+            set.set(i, (isalnum(i) || (i == '_') || (i == '-') || (i == '.')));
+        }
+
+        return set;
+    }();
+
+    return safe_set;
+}
@@ -0,0 +1,243 @@
+/**
+ * Shadow Daemon -- Web Application Firewall
+ *
+ *   Copyright (C) 2014-2022 Hendrik Buchwald <hb@zecure.org>
+ *
+ * This file is part of Shadow Daemon. Shadow Daemon is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, version 2.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#include <memory>
+#include <boost/chrono.hpp>
+#include <boost/make_shared.hpp>
+
+#include "scan_batcher.h"
+#include "safe_chars.h"
+#include "case_fold.h"
+
+void swd::scan_batcher::set_limits(int window, int max_inputs) {
+    window_ = window;
+    max_inputs_ = ((max_inputs > 0) ? max_inputs : 1);
+}
+
+bool swd::scan_batcher::is_enabled() const {
+    return (window_ > -1);
+}
+
+void swd::scan_batcher::match(const swd::blacklist_filter_set_ptr& filter_set,
+ const std::vector<const std::string*>& inputs, const std::vector<int>& thresholds,
+ const evaluator& evaluate, std::vector<std::vector<unsigned int>>& matches,
+ std::vector<bool>& complete) {
+    /* Every request prepares its own strings before it joins a batch. */
+    std::vector<std::string> folded(inputs.size());
+    std::vector<bool> safe(inputs.size());
+
+    for (std::size_t j = 0; j < inputs.size(); j++) {
+        swd::case_fold::fold(*inputs[j], folded[j]);
+        safe[j] = swd::safe_chars::contains_only(inputs[j]->data(),
+         inputs[j]->data() + inputs[j]->length());
+    }
+
+    boost::unique_lock scoped_lock(mutex_);
+
+    /* Batches only contain strings for the same filters, others are scanned alone. */
+    bool alone = (current_ && (current_->filter_set != filter_set));
+    bool leader = !current_;
+
+    boost::shared_ptr<batch> own_batch = current_;
+
+    if (alone || leader) {
+        own_batch = boost::make_shared<batch>();
+        own_batch->filter_set = filter_set;
+    }
+
+    if (leader) {
+        current_ = own_batch;
+    }
+
+    std::size_t offset = own_batch->inputs.size();
+    own_batch->inputs.insert(own_batch->inputs.end(), inputs.begin(), inputs.end());
+    own_batch->safe.insert(own_batch->safe.end(), safe.begin(), safe.end());
+    own_batch->thresholds.insert(own_batch->thresholds.end(), thresholds.begin(), thresholds.end());
+
+    for (std::size_t j = 0; j < folded.size(); j++) {
+        own_batch->folded.push_back(&folded[j]);
+    }
+
+    /* Full batches take no more strings, the next request starts a new one. */
+    if (alone || (own_batch->inputs.size() >= max_inputs_)) {
+        close(*own_batch);
+        changed_.notify_all();
+    }
+
+    if (leader) {
+        boost::chrono::steady_clock::time_point deadline = boost::chrono::steady_clock::now()
+         + boost::chrono::microseconds(window_);
+
+        while (!own_batch->closed && (changed_.wait_until(scoped_lock, deadline)
+         != boost::cv_status::timeout));
+
+        if (!own_batch->closed) {
+            close(*own_batch);
+            changed_.notify_all();
+        }
+    } else {
+        while (!own_batch->closed) {
+            changed_.wait(scoped_lock);
+        }
+    }
+
+    work(*own_batch, evaluate, scoped_lock);
+
+    scoped_lock.unlock();
+
+    if (own_batch->error) {
+        std::rethrow_exception(own_batch->error);
+    }
+
+    matches.assign(inputs.size(), std::vector<unsigned int>());
+    complete.assign(inputs.size(), true);
+
+    /* The filters are visited by their index, so the matches are sorted. */
+    for (unsigned int i = 0; i < own_batch->hits.size(); i++) {
+        for (std::size_t j: own_batch->hits[i]) {
+            if ((j >= offset) && (j < offset + inputs.size())) {
+                matches[j - offset].push_back(i);
+            }
+        }
+
+        for (std::size_t j: own_batch->skipped[i]) {
+            if ((j >= offset) && (j < offset + inputs.size())) {
+                complete[j - offset] = false;
+            }
+        }
+    }
+
+    /* Strings that stopped early do not have the results of all filters. */
+    for (std::size_t j = 0; j < inputs.size(); j++) {
+        if ((thresholds[j] > -1) && (own_batch->impacts[offset + j] > (unsigned int) thresholds[j])) {
+            complete[j] = false;
+        }
+    }
+}
+
+void swd::scan_batcher::close(batch& own_batch) {
+    if (current_.get() == &own_batch) {
+        current_.reset();
+    }
+
+    std::size_t filters = own_batch.filter_set->get_filters().size();
+    std::size_t inputs = own_batch.inputs.size();
+
+    /* The order only matters if strings can stop early. */
+    for (int threshold: own_batch.thresholds) {
+        if (threshold > -1) {
+            own_batch.order = own_batch.filter_set->get_order();
+            break;
+        }
+    }
+
+    own_batch.impacts = std::make_unique<std::atomic<unsigned int>[]>(inputs);
+
+    for (std::size_t j = 0; j < inputs; j++) {
+        own_batch.impacts[j] = 0;
+    }
+
+    own_batch.hits.resize(filters);
+    own_batch.skipped.resize(filters);
+    own_batch.closed = true;
+    own_batch.done = (filters == 0);
+}
+
+void swd::scan_batcher::work(batch& own_batch, const evaluator& evaluate,
+ boost::unique_lock<boost::mutex>& scoped_lock) {
+    scoped_lock.unlock();
+
+    const swd::blacklist_filters& filters = own_batch.filter_set->get_filters();
+
+    /**
+     * Every request takes the next filter and runs it on all strings of the
+     * batch. Only the request that took a filter writes its results.
+     */
+    for (;;) {
+        std::size_t k = own_batch.next++;
+
+        if (k >= filters.size()) {
+            break;
+        }
+
+        unsigned int i = (own_batch.order ? (*own_batch.order)[k] : k);
+        const swd::blacklist_filter_ptr& filter = filters[i];
+
+        try {
+            for (std::size_t j = 0; j < own_batch.inputs.size(); j++) {
+                int threshold = own_batch.thresholds[j];
+
+                if ((threshold > -1) && (own_batch.impacts[j] > (unsigned int) threshold)) {
+                    continue;
+                }
+
+                if (own_batch.safe[j] && filter->needs_special()) {
+                    continue;
+                }
+
+                bool evaluated = true;
+
+                if (evaluate(filter, *own_batch.inputs[j], *own_batch.folded[j], evaluated)) {
+                    own_batch.hits[i].push_back(j);
+                    own_batch.impacts[j] += filter->get_impact();
+                }
+
+                if (!evaluated) {
+                    own_batch.skipped[i].push_back(j);
+                }
+            }
+        } catch (...) {
+            scoped_lock.lock();
+
+            if (!own_batch.error) {
+                own_batch.error = std::current_exception();
+            }
+
+            scoped_lock.unlock();
+        }
+
+        scoped_lock.lock();
+
+        if (++own_batch.finished == filters.size()) {
+            own_batch.done = true;
+            changed_.notify_all();
+        }
+
+        scoped_lock.unlock();
+    }
+
+    /* The strings of the other requests must stay valid until the batch is done. */
+    scoped_lock.lock();
+
+    while (!own_batch.done) {
+        changed_.wait(scoped_lock);
+    }
+}
@@ -0,0 +1,165 @@
+/**
+ * Shadow Daemon -- Web Application Firewall
+ *
+ *   Copyright (C) 2014-2022 Hendrik Buchwald <hb@zecure.org>
+ *
+ * This file is part of Shadow Daemon. Shadow Daemon is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, version 2.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#include <random>
+
+#include "scan_memo.h"
+
+namespace {
+    inline std::uint64_t rotl(std::uint64_t x, int b) {
+        return (x << b) | (x >> (64 - b));
+    }
+
+    inline void sipround(std::uint64_t& v0, std::uint64_t& v1, std::uint64_t& v2,
+     std::uint64_t& v3) {
+        v0 += v1; v1 = rotl(v1, 13); v1 ^= v0; v0 = rotl(v0, 32);
+        v2 += v3; v3 = rotl(v3, 16); v3 ^= v2;
+        v0 += v3; v3 = rotl(v3, 21); v3 ^= v0;
+        v2 += v1; v1 = rotl(v1, 17); v1 ^= v2; v2 = rotl(v2, 32);
+    }
+}
+
+swd::scan_memo::scan_memo(int capacity) {
+    std::random_device random;
+
+    key_[0] = ((std::uint64_t)random() << 32) | random();
+    key_[1] = ((std::uint64_t)random() << 32) | random();
+
+    set_capacity(capacity);
+}
+
+void swd::scan_memo::set_capacity(int capacity) {
+    for (auto& shard: shards_) {
+        boost::unique_lock scoped_lock(shard.mutex);
+        shard.entries.clear();
+    }
+
+    shard_capacity_ = ((capacity > 0) ? ((capacity + shard_count - 1) / shard_count) : 0);
+}
+
+bool swd::scan_memo::find(unsigned long long generation, const std::string& input,
+ std::vector<unsigned int>& matches) {
+    if (shard_capacity_ == 0) {
+        return false;
+    }
+
+    std::uint64_t key = hash(generation, input);
+    shard& shard = shards_[key & (shard_count - 1)];
+
+    boost::unique_lock scoped_lock(shard.mutex);
+
+    auto it = shard.entries.find(key);
+
+    if ((it == shard.entries.end()) || (it->second.generation != generation) ||
+     (it->second.input != input)) {
+        return false;
+    }
+
+    matches = it->second.matches;
+    return true;
+}
+
+void swd::scan_memo::add(unsigned long long generation, const std::string& input,
+ const std::vector<unsigned int>& matches) {
+    if (shard_capacity_ == 0) {
+        return;
+    }
+
+    std::uint64_t key = hash(generation, input);
+    shard& shard = shards_[key & (shard_count - 1)];
+
+    boost::unique_lock scoped_lock(shard.mutex);
+
+    /* Make room for the new entry, outdated generations are replaced this way as well. */
+    if ((shard.entries.size() >= shard_capacity_) && (shard.entries.count(key) == 0)) {
+        shard.entries.erase(shard.entries.begin());
+    }
+
+    shard.entries[key] = {generation, input, matches};
+}
+
+std::size_t swd::scan_memo::get_size() {
+    std::size_t size = 0;
+
+    for (auto& shard: shards_) {
+        boost::unique_lock scoped_lock(shard.mutex);
+        size += shard.entries.size();
+    }
+
+    return size;
+}
+
+std::uint64_t swd::scan_memo::hash(unsigned long long generation, const std::string& input) const {
+    /* The generation is part of the key, so every filter set uses other hashes. */
+    std::uint64_t k0 = key_[0] ^ generation;
+    std::uint64_t k1 = key_[1];
+
+    std::uint64_t v0 = 0x736f6d6570736575ULL ^ k0;
+    std::uint64_t v1 = 0x646f72616e646f6dULL ^ k1;
+    std::uint64_t v2 = 0x6c7967656e657261ULL ^ k0;
+    std::uint64_t v3 = 0x7465646279746573ULL ^ k1;
+
+    const unsigned char* data = (const unsigned char*)input.data();
+    std::size_t length = input.length();
+    std::size_t blocks = length - (length % 8);
+
+    for (std::size_t i = 0; i < blocks; i += 8) {
+        std::uint64_t m = 0;
+
+        for (std::size_t j = 0; j < 8; j++) {
+            m |= ((std::uint64_t)data[i + j] << (8 * j));
+        }
+
+        v3 ^= m;
+        sipround(v0, v1, v2, v3);
+        sipround(v0, v1, v2, v3);
+        v0 ^= m;
+    }
+
+    std::uint64_t b = ((std::uint64_t)length << 56);
+
+    for (std::size_t j = 0; j < (length % 8); j++) {
+        b |= ((std::uint64_t)data[blocks + j] << (8 * j));
+    }
+
+    v3 ^= b;
+    sipround(v0, v1, v2, v3);
+    sipround(v0, v1, v2, v3);
+    v0 ^= b;
+
+    v2 ^= 0xff;
+    sipround(v0, v1, v2, v3);
+    sipround(v0, v1, v2, v3);
+    sipround(v0, v1, v2, v3);
+    sipround(v0, v1, v2, v3);
+
+    return (v0 ^ v1 ^ v2 ^ v3);
+}
@@ -0,0 +1,155 @@
+/**
+ * Shadow Daemon -- Web Application Firewall
+ *
+ *   Copyright (C) 2014-2022 Hendrik Buchwald <hb@zecure.org>
+ *
+ * This file is part of Shadow Daemon. Shadow Daemon is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, version 2.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <boost/bind.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include "scan_pool.h"
+
+namespace {
+    /**
+     * The state of a run is shared with the helpers, because helpers that
+     * start after the run is done still have to look at it.
+     */
+    struct job {
+        job(std::size_t count, const std::function<void(std::size_t)>& task) :
+         count(count),
+         task(task) {
+        }
+
+        void work() {
+            for (;;) {
+                std::size_t index = next++;
+
+                if (index >= count) {
+                    return;
+                }
+
+                try {
+                    task(index);
+                } catch (...) {
+                    boost::unique_lock scoped_lock(mutex);
+
+                    if (!error) {
+                        error = std::current_exception();
+                    }
+                }
+
+                if (++done == count) {
+                    boost::unique_lock scoped_lock(mutex);
+                    finished.notify_all();
+                }
+            }
+        }
+
+        const std::size_t count;
+        const std::function<void(std::size_t)> task;
+        std::atomic<std::size_t> next{0};
+        std::atomic<std::size_t> done{0};
+        boost::mutex mutex;
+        boost::condition_variable finished;
+        std::exception_ptr error;
+    };
+}
+
+swd::scan_pool::scan_pool() :
+ work_(std::make_unique<boost::asio::io_service::work>(io_service_)) {
+}
+
+void swd::scan_pool::start(std::size_t thread_pool_size) {
+    using signature_type = std::size_t (boost::asio::io_service::*)();
+    signature_type run_ptr = &boost::asio::io_service::run;
+
+    for (std::size_t i = 0; i < thread_pool_size; ++i) {
+        threads_.create_thread(
+            boost::bind(run_ptr, &io_service_)
+        );
+    }
+
+    thread_pool_size_ = thread_pool_size;
+}
+
+void swd::scan_pool::stop() {
+    work_.reset();
+    io_service_.stop();
+    threads_.join_all();
+}
+
+void swd::scan_pool::set_threshold(int size) {
+    threshold_ = size;
+}
+
+bool swd::scan_pool::should_split(const swd::parameters& parameters) const {
+    if ((threshold_ < 0) || (thread_pool_size_ == 0) || parameters.empty()) {
+        return false;
+    }
+
+    std::size_t size = 0;
+
+    for (const auto& parameter: parameters) {
+        size += parameter->get_path().length() + parameter->get_value().length();
+
+        if (size >= (std::size_t) threshold_) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void swd::scan_pool::run(std::size_t count, const std::function<void(std::size_t)>& task) {
+    boost::shared_ptr<job> state = boost::make_shared<job>(count, task);
+
+    /* There is no need for more helpers than tasks besides the one of the caller. */
+    std::size_t helpers = std::min(thread_pool_size_, (count > 0 ? count - 1 : 0));
+
+    for (std::size_t i = 0; i < helpers; ++i) {
+        io_service_.post(boost::bind(&job::work, state));
+    }
+
+    state->work();
+
+    /* Wait for the tasks that the helpers took. */
+    boost::unique_lock scoped_lock(state->mutex);
+
+    while (state->done < count) {
+        state->finished.wait(scoped_lock);
+    }
+
+    if (state->error) {
+        std::rethrow_exception(state->error);
+    }
+}
@@ -33,21 +33,27 @@
 #include <boost/bind.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/thread/thread.hpp>
+#include <algorithm>
+#include <sstream>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "server.h"
 #include "config.h"
 #include "log.h"
 #include "shared.h"
 #include "core_exception.h"
+#include "database_exception.h"
+#include "regex_engine.h"
 
 swd::server::server(swd::storage_ptr storage,
  swd::database_ptr database, swd::cache_ptr cache) :
  signals_stop_(io_service_),
  signals_reload_(io_service_),
+ signals_stats_(io_service_),
  acceptor_(io_service_),
- context_(boost::asio::ssl::context::sslv23),
+ context_(boost::asio::ssl::context::tls_server),
  storage_(std::move(storage)),
  database_(std::move(database)),
  cache_(std::move(cache)) {
@@ -72,18 +78,63 @@ swd::server::server(swd::storage_ptr storage,
     signals_reload_.async_wait(
         boost::bind(&swd::server::handle_reload, this)
     );
+
+    /* And for statistics signals. */
+    signals_stats_.add(SIGUSR1);
+
+    signals_stats_.async_wait(
+        boost::bind(&swd::server::handle_stats, this)
+    );
 }
 
 void swd::server::init() {
+    admission_->set_limits(
+        swd::config::i()->get<int>("max-connections"),
+        swd::config::i()->get<int>("max-analyses"),
+        swd::config::i()->get<int>("rate-limit"),
+        swd::config::i()->get<int>("rate-burst"),
+        swd::config::i()->get<int>("max-failures")
+    );
+
+    cache_->get_scan_memo()->set_capacity(
+        swd::config::i()->get<int>("scan-memo-size")
+    );
+
+    cache_->get_scan_batcher()->set_limits(
+        swd::config::i()->get<int>("batch-window"),
+        swd::config::i()->get<int>("batch-size")
+    );
+
+    scan_pool_->set_threshold(
+        swd::config::i()->get<int>("parallel-scan-size")
+    );
+
+    cache_->get_filter_quarantine()->set_budget(
+        swd::config::i()->get<int>("filter-cost-budget"),
+        swd::config::i()->get<int>("filter-sample-rate")
+    );
+
+    /* The engine has to be set before the filters are loaded. */
+    swd::regex_engine::set_default_type(
+        swd::config::i()->get<std::string>("regex-engine")
+    );
+
+    check_regex_engines();
+
     /**
      * We try to open the tcp port. If asio throws an error one of the core
      * components doesn't work and there is no need to continue in that case.
      */
     try {
         if (swd::config::i()->defined("ssl")) {
+            /**
+             * The tls_server method negotiates the highest version both sides
+             * support, i.e. TLS 1.3 with a recent OpenSSL.
+             */
             context_.set_options(
                 boost::asio::ssl::context::default_workarounds
                 | boost::asio::ssl::context::no_sslv2
+                | boost::asio::ssl::context::no_sslv3
                 | boost::asio::ssl::context::single_dh_use
             );
 
@@ -96,9 +147,18 @@ void swd::server::init() {
                 boost::asio::ssl::context::pem
             );
 
-            context_.use_tmp_dh_file(
-                swd::config::i()->get<std::string>("ssl-dh")
-            );
+            /* DH parameters are only used by old ciphers, ECDHE does not need them. */
+            if (swd::config::i()->defined("ssl-dh")) {
+                context_.use_tmp_dh_file(
+                    swd::config::i()->get<std::string>("ssl-dh")
+                );
+            } else {
+#if defined(SSL_CTX_set_dh_auto)
+                SSL_CTX_set_dh_auto(context_.native_handle(), 1);
+#endif /* defined(SSL_CTX_set_dh_auto) */
+            }
+
+            init_ssl_sessions();
         }
 
         /* Open the acceptor with the option to reuse the address (i.e. SO_REUSEADDR). */
@@ -122,7 +182,74 @@ void swd::server::init() {
     start_accept();
 }
 
-void swd::server::start(std::size_t thread_pool_size) {
+void swd::server::check_regex_engines() {
+    swd::blacklist_filters filters;
+
+    try {
+        filters = cache_->get_blacklist_filters();
+    } catch (const swd::exceptions::database_exception& e) {
+        swd::log::i()->send(swd::uncritical_error, e.get_message());
+        return;
+    }
+
+    /* Report for every engine which filters it does not support. */
+    for (const auto& type: swd::regex_engine::get_types()) {
+        std::stringstream unsupported;
+
+        for (const auto& filter: filters) {
+            try {
+                swd::regex_engine::compile(type, filter->get_regex(), true);
+            } catch (const std::runtime_error& e) {
+                unsupported << (unsupported.tellp() > 0 ? ", " : "") << filter->get_id();
+            }
+        }
+
+        if (unsupported.tellp() == 0) {
+            swd::log::i()->send(swd::notice, "Regex engine " + type
+             + " can compile all blacklist filters");
+        } else {
+            swd::log::i()->send(
+                (type == swd::regex_engine::get_default_type() ? swd::warning : swd::notice),
+                "Regex engine " + type + " can not compile blacklist filters "
+                + unsupported.str()
+            );
+        }
+    }
+}
+
+void swd::server::init_ssl_sessions() {
+    SSL_CTX* ctx = context_.native_handle();
+
+    int cache_size = swd::config::i()->get<int>("ssl-session-cache");
+
+    /**
+     * Connectors open a new connection for every request, so without resumption
+     * every request pays for a full handshake. OpenSSL treats a size of zero
+     * as unlimited, so zero disables the cache as well.
+     */
+    if (cache_size <= 0) {
+        SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_OFF);
+        SSL_CTX_set_options(ctx, SSL_OP_NO_TICKET);
+        return;
+    }
+
+    const unsigned char session_id_context[] = "shadowd";
+
+    SSL_CTX_set_session_id_context(ctx, session_id_context, sizeof(session_id_context) - 1);
+    SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_SERVER);
+    SSL_CTX_sess_set_cache_size(ctx, cache_size);
+    SSL_CTX_set_timeout(ctx, swd::config::i()->get<int>("ssl-session-timeout"));
+
+    /* Stateless tickets allow resumption without a cache lookup. */
+    SSL_CTX_clear_options(ctx, SSL_OP_NO_TICKET);
+}
+
+void swd::server::start(std::size_t thread_pool_size, std::size_t analysis_pool_size,
+ std::size_t scan_pool_size) {
+    /* The analyses run on their own threads, so that they can not block the io. */
+    analysis_pool_->start(analysis_pool_size);
+    scan_pool_->start(scan_pool_size);
+
     /**
      * In some cases the compiler can't determine which overload of run was intended
      * at the bind, resulting in a compilation error.
@@ -150,6 +277,10 @@ void swd::server::start(std::size_t thread_pool_size) {
     for (const auto& thread: threads) {
         thread->join();
     }
+
+    /* There are no connections anymore that could wait for an analysis. */
+    analysis_pool_->stop();
+    scan_pool_->stop();
 }
 
 void swd::server::start_accept() {
@@ -162,12 +293,16 @@ void swd::server::start_accept() {
             ssl,
             storage_,
             database_,
-            cache_
+            cache_,
+            buffer_pool_,
+            admission_,
+            analysis_pool_,
+            scan_pool_
         )
     );
 
     acceptor_.async_accept(
-        (ssl ? new_connection_->ssl_socket() : new_connection_->socket()),
+        new_connection_->socket(),
         boost::bind(
             &swd::server::handle_accept,
             this,
@@ -212,3 +347,62 @@ void swd::server::handle_reload() {
     /* Reset the cache by deleting all elements. */
     cache_->reset_all();
 }
+
+void swd::server::handle_stats() {
+    swd::log::i()->send(swd::notice, "Received a statistics signal");
+
+    swd::log::i()->send(swd::notice, "Analysis pool: "
+     + std::to_string(analysis_pool_->get_queued()) + " queued, "
+     + std::to_string(analysis_pool_->get_active()) + " active, "
+     + std::to_string(analysis_pool_->get_completed()) + " completed, "
+     + std::to_string(analysis_pool_->get_max_wait()) + " ms max wait");
+
+    swd::blacklist_filters filters;
+
+    try {
+        filters = cache_->get_blacklist_filters();
+    } catch (const swd::exceptions::database_exception& e) {
+        swd::log::i()->send(swd::uncritical_error, e.get_message());
+    }
+
+    /**
+     * The most expensive filters are reported first. The analysis threads keep
+     * updating the statistics, so the sort uses a snapshot of the costs.
+     */
+    std::vector<std::pair<unsigned long long, swd::blacklist_filter_ptr>> costs;
+    costs.reserve(filters.size());
+
+    for (const auto& filter: filters) {
+        costs.emplace_back(filter->get_stats().get_nanoseconds(), filter);
+    }
+
+    std::sort(costs.begin(), costs.end(), [](const std::pair<unsigned long long,
+     swd::blacklist_filter_ptr>& a, const std::pair<unsigned long long,
+     swd::blacklist_filter_ptr>& b) {
+        return a.first > b.first;
+    });
+
+    for (const auto& cost: costs) {
+        const swd::blacklist_filter_ptr& filter = cost.second;
+        swd::filter_stats& stats = filter->get_stats();
+
+        if ((stats.get_evaluations() == 0) && !stats.is_quarantined()) {
+            continue;
+        }
+
+        swd::log::i()->send(swd::notice, "Blacklist filter "
+         + std::to_string(filter->get_id()) + ": "
+         + std::to_string(stats.get_evaluations()) + " evaluations, "
+         + std::to_string(stats.get_matches()) + " matches, "
+         + std::to_string(stats.get_aborts()) + " aborts, "
+         + std::to_string(stats.get_nanoseconds()) + " ns total, "
+         + std::to_string(stats.get_average_nanoseconds()) + " ns average"
+         + (stats.is_quarantined() ? ", quarantined with "
+         + std::to_string(stats.get_quarantined_inputs()) + " inputs" : ""));
+    }
+
+    /* Wait for the next signal. */
+    signals_stats_.async_wait(
+        boost::bind(&swd::server::handle_stats, this)
+    );
+}
@@ -128,8 +128,12 @@ void swd::shadowd::start() {
     /* Start the cache worker thread. */
     cache_->start();
 
-    /* This adds threads to the threadpool and keeps everything running. */
-    server_.start(swd::config::i()->get<int>("threads"));
+    /* This adds threads to the threadpools and keeps everything running. */
+    server_.start(
+        swd::config::i()->get<int>("threads"),
+        swd::config::i()->get<int>("analysis-threads"),
+        swd::config::i()->get<int>("scan-threads")
+    );
 }
 
 int main(int argc, char** argv) {
@@ -159,7 +159,7 @@ void swd::storage::save(const swd::request_ptr& request) {
     }
 
     /* Now iterate over all parameters. */
-    swd::parameters parameters = request->get_parameters();
+    const swd::parameters& parameters = request->get_parameters();
 
     for (const auto& parameter: parameters) {
         unsigned long long parameter_id;
@@ -34,49 +34,74 @@
 #include "whitelist.h"
 #include "whitelist_rule.h"
 #include "log.h"
+#include "case_fold.h"
 
-swd::whitelist::whitelist(swd::cache_ptr cache) :
- cache_(std::move(cache)) {
+swd::whitelist::whitelist(swd::cache_ptr cache, swd::scan_pool_ptr scan_pool) :
+ cache_(std::move(cache)),
+ scan_pool_(std::move(scan_pool)) {
 }
 
 void swd::whitelist::scan(const swd::request_ptr& request) const {
-    swd::parameters parameters = request->get_parameters();
+    const swd::parameters& parameters = request->get_parameters();
+
+    /* Large requests are split between threads, every parameter is checked on its own. */
+    if (scan_pool_ && scan_pool_->should_split(parameters)) {
+        scan_pool_->run(parameters.size(), [&](std::size_t i) {
+            std::string folded;
+            this->scan_parameter(request, parameters[i], folded);
+        });
+
+        return;
+    }
+
+    /* The buffer for the lowercase versions of all values. */
+    std::string folded;
 
     /* Iterate over all parameters. */
     for (const auto& parameter: parameters) {
-        /* Import the rules from the database. */
-        swd::whitelist_rules rules = cache_->get_whitelist_rules(
-            request->get_profile()->get_id(),
-            request->get_caller(),
-            parameter->get_path()
-        );
+        this->scan_parameter(request, parameter, folded);
+    }
+}
 
-        /**
-         * The parameter needs at least one rule to pass the check. Otherwise
-         * it wouldn't be a whitelist.
-         */
-        parameter->set_total_whitelist_rules((int)rules.size());
+void swd::whitelist::scan_parameter(const swd::request_ptr& request,
+ const swd::parameter_ptr& parameter, std::string& folded) const {
+    /* Import the rules from the database. */
+    swd::whitelist_rules rules = cache_->get_whitelist_rules(
+        request->get_profile()->get_id(),
+        request->get_caller(),
+        parameter->get_path()
+    );
 
-        if (parameter->get_total_whitelist_rules() == 0) {
-            parameter->set_threat(true);
-        }
+    /**
+     * The parameter needs at least one rule to pass the check. Otherwise
+     * it wouldn't be a whitelist.
+     */
+    parameter->set_total_whitelist_rules((int)rules.size());
+
+    if (parameter->get_total_whitelist_rules() == 0) {
+        parameter->set_threat(true);
+    }
 
-        /* Iterate over all rules. */
-        for (const auto& rule: rules) {
-            try {
-                /* Add pointers to all rules that are not adhered to. */
-                if (!rule->is_adhered_to(parameter->get_value())) {
-                    parameter->add_whitelist_rule(rule);
-                    parameter->set_threat(true);
-                }
-            } catch (...) {
-                swd::log::i()->send(swd::uncritical_error,
-                 "Unexpected whitelist problem");
+    /* The value is folded only once for all rules. */
+    if (!rules.empty()) {
+        swd::case_fold::fold(parameter->get_value(), folded);
+    }
 
-                /* Add the rule anyway to avoid a potential bypass. */
+    /* Iterate over all rules. */
+    for (const auto& rule: rules) {
+        try {
+            /* Add pointers to all rules that are not adhered to. */
+            if (!rule->is_adhered_to(parameter->get_value(), folded)) {
                 parameter->add_whitelist_rule(rule);
                 parameter->set_threat(true);
             }
+        } catch (...) {
+            swd::log::i()->send(swd::uncritical_error,
+             "Unexpected whitelist problem");
+
+            /* Add the rule anyway to avoid a potential bypass. */
+            parameter->add_whitelist_rule(rule);
+            parameter->set_threat(true);
         }
     }
 }
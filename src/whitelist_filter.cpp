@@ -30,6 +30,7 @@
  */
 
 #include "whitelist_filter.h"
+#include "case_fold.h"
 
 void swd::whitelist_filter::set_id(const unsigned long long& id) {
     id_ = id;
@@ -40,9 +41,30 @@ unsigned long long swd::whitelist_filter::get_id() const {
 }
 
 void swd::whitelist_filter::set_regex(const std::string& regex) {
-    regex_.set_expression(regex, boost::regex::icase | boost::regex::mod_s);
+    /* Folded expressions match folded input without the cost of icase. */
+    std::string folded_regex;
+    folded_ = swd::case_fold::fold_regex(regex, folded_regex);
+
+    if (folded_) {
+        engine_ = swd::regex_engine::compile(folded_regex, false);
+    } else {
+        engine_ = swd::regex_engine::compile(regex, true);
+    }
+
+    regex_ = regex;
 }
 
 bool swd::whitelist_filter::matches(const std::string& input) const {
-    return regex_search(input, regex_);
+    if (!folded_) {
+        return engine_->search(input);
+    }
+
+    std::string folded;
+    swd::case_fold::fold(input, folded);
+
+    return engine_->search(folded);
+}
+
+bool swd::whitelist_filter::matches(const std::string& input, const std::string& folded) const {
+    return engine_->search(folded_ ? folded : input);
 }
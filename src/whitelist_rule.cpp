@@ -30,6 +30,7 @@
  */
 
 #include "whitelist_rule.h"
+#include "case_fold.h"
 
 void swd::whitelist_rule::set_id(const unsigned long long& id) {
     id_ = id;
@@ -52,6 +53,13 @@ void swd::whitelist_rule::set_max_length(const int& max_length) {
 }
 
 bool swd::whitelist_rule::is_adhered_to(const std::string& value) const {
+    std::string folded;
+    swd::case_fold::fold(value, folded);
+
+    return is_adhered_to(value, folded);
+}
+
+bool swd::whitelist_rule::is_adhered_to(const std::string& value, const std::string& folded) const {
     unsigned long length = value.length();
 
     if ((min_length_ > 0) && (length < min_length_)) {
@@ -62,5 +70,5 @@ bool swd::whitelist_rule::is_adhered_to(const std::string& value) const {
         return false;
     }
 
-    return filter_->matches(value);
+    return filter_->matches(value, folded);
 }
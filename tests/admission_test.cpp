@@ -0,0 +1,142 @@
+/**
+ * Shadow Daemon -- Web Application Firewall
+ *
+ *   Copyright (C) 2014-2022 Hendrik Buchwald <hb@zecure.org>
+ *
+ * This file is part of Shadow Daemon. Shadow Daemon is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, version 2.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include <boost/make_shared.hpp>
+
+#include "admission.h"
+
+BOOST_AUTO_TEST_SUITE(admission_test)
+
+BOOST_AUTO_TEST_CASE(unlimited) {
+    swd::admission admission;
+    admission.set_limits(-1, -1, -1, 1);
+
+    boost::asio::ip::address address = boost::asio::ip::address::from_string("127.0.0.1");
+
+    for (int i = 0; i < 10; i++) {
+        BOOST_CHECK(admission.add_connection(address));
+        BOOST_CHECK(admission.add_analysis());
+    }
+
+    BOOST_CHECK(admission.get_connections() == 10);
+    BOOST_CHECK(admission.get_analyses() == 10);
+}
+
+BOOST_AUTO_TEST_CASE(max_connections) {
+    swd::admission admission;
+    admission.set_limits(1, -1, -1, 1);
+
+    boost::asio::ip::address address = boost::asio::ip::address::from_string("127.0.0.1");
+
+    BOOST_CHECK(admission.add_connection(address));
+    BOOST_CHECK(!admission.add_connection(address));
+    BOOST_CHECK(admission.get_connections() == 2);
+
+    admission.remove_connection();
+    admission.remove_connection();
+    BOOST_CHECK(admission.add_connection(address));
+}
+
+BOOST_AUTO_TEST_CASE(max_analyses) {
+    swd::admission_ptr admission = boost::make_shared<swd::admission>();
+    admission->set_limits(-1, 1, -1, 1);
+
+    {
+        swd::analysis_slot slot1(admission);
+        BOOST_CHECK(slot1.is_granted());
+
+        swd::analysis_slot slot2(admission);
+        BOOST_CHECK(!slot2.is_granted());
+        BOOST_CHECK(admission->get_analyses() == 1);
+    }
+
+    BOOST_CHECK(admission->get_analyses() == 0);
+
+    swd::analysis_slot slot3(admission);
+    BOOST_CHECK(slot3.is_granted());
+}
+
+BOOST_AUTO_TEST_CASE(rate_limit) {
+    swd::admission admission;
+    admission.set_limits(-1, -1, 0, 2);
+
+    boost::asio::ip::address address1 = boost::asio::ip::address::from_string("127.0.0.1");
+    boost::asio::ip::address address2 = boost::asio::ip::address::from_string("127.0.0.2");
+
+    BOOST_CHECK(admission.add_connection(address1));
+    BOOST_CHECK(admission.add_connection(address1));
+    BOOST_CHECK(!admission.add_connection(address1));
+    BOOST_CHECK(admission.add_connection(address2));
+}
+
+BOOST_AUTO_TEST_CASE(max_failures) {
+    swd::admission admission;
+    admission.set_limits(-1, -1, -1, 1, 2);
+
+    boost::asio::ip::address address1 = boost::asio::ip::address::from_string("127.0.0.1");
+    boost::asio::ip::address address2 = boost::asio::ip::address::from_string("127.0.0.2");
+
+    BOOST_CHECK(!admission.is_blocked(address1));
+    admission.add_failure(address1);
+    BOOST_CHECK(!admission.is_blocked(address1));
+    admission.add_failure(address1);
+    BOOST_CHECK(admission.is_blocked(address1));
+    BOOST_CHECK(!admission.is_blocked(address2));
+}
+
+BOOST_AUTO_TEST_CASE(bucket_eviction) {
+    swd::admission admission;
+    admission.set_limits(-1, -1, 0, 1);
+
+    boost::asio::ip::address address1 = boost::asio::ip::address::from_string("127.0.0.1");
+
+    BOOST_CHECK(admission.add_connection(address1));
+    BOOST_CHECK(!admission.add_connection(address1));
+
+    /* The table is bounded, so the least recently used source is forgotten eventually. */
+    for (unsigned long i = 0; i < 65536; i++) {
+        admission.add_connection(boost::asio::ip::address_v4(0x0a000000 + i));
+    }
+
+    BOOST_CHECK(admission.add_connection(address1));
+}
+
+BOOST_AUTO_TEST_CASE(count_shed) {
+    swd::admission admission;
+
+    BOOST_CHECK(admission.count_shed() == 1);
+    BOOST_CHECK(admission.count_shed() == 0);
+    BOOST_CHECK(admission.count_shed() == 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,64 @@
+/**
+ * Shadow Daemon -- Web Application Firewall
+ *
+ *   Copyright (C) 2014-2022 Hendrik Buchwald <hb@zecure.org>
+ *
+ * This file is part of Shadow Daemon. Shadow Daemon is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, version 2.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "analysis_pool.h"
+
+BOOST_AUTO_TEST_SUITE(analysis_pool_test)
+
+BOOST_AUTO_TEST_CASE(run_tasks) {
+    swd::analysis_pool analysis_pool;
+    std::atomic<int> counter{0};
+
+    /* Tasks are queued until the workers are started. */
+    for (int i = 0; i < 10; i++) {
+        analysis_pool.post([&counter]() { ++counter; });
+    }
+
+    BOOST_CHECK(analysis_pool.get_queued() == 10);
+
+    analysis_pool.start(2);
+
+    while (analysis_pool.get_completed() < 10) {
+        boost::this_thread::yield();
+    }
+
+    analysis_pool.stop();
+
+    BOOST_CHECK(counter == 10);
+    BOOST_CHECK(analysis_pool.get_queued() == 0);
+    BOOST_CHECK(analysis_pool.get_active() == 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -65,4 +65,58 @@ BOOST_AUTO_TEST_CASE(not_matching_blacklist_filter) {
     BOOST_CHECK(filter->matches("bar") == false);
 }
 
+BOOST_AUTO_TEST_CASE(windowed_blacklist_filter) {
+    swd::blacklist_filter_ptr filter(new swd::blacklist_filter);
+
+    filter->set_id(1);
+    filter->set_impact(5);
+
+    /* A bounded match across the border of two windows. */
+    filter->set_regex("<script>");
+    BOOST_CHECK(filter->get_max_span() == 8);
+
+    std::string input = std::string(1020, 'a') + "<script>" + std::string(5000, 'a');
+    BOOST_CHECK(filter->matches(input, input, 1024) == true);
+    BOOST_CHECK(filter->matches(input, input, 0) == true);
+    BOOST_CHECK(filter->matches(std::string(6000, 'a'), std::string(6000, 'a'), 1024) == false);
+
+    /* A bounded span longer than the window. */
+    filter->set_regex("<a{2000}>");
+    input = std::string(1000, 'a') + "<" + std::string(2000, 'a') + ">" + std::string(5000, 'a');
+    BOOST_CHECK(filter->matches(input, input, 1024) == true);
+
+    /* Unbounded filters test the input as a whole. */
+    filter->set_regex("<.*>");
+    BOOST_CHECK(filter->get_max_span() == -1);
+
+    input = std::string(1000, 'a') + "<" + std::string(3000, 'a') + ">" + std::string(5000, 'a');
+    BOOST_CHECK(filter->matches(input, input, 1024) == true);
+    BOOST_CHECK(filter->matches(input, input, 0) == true);
+
+    /* With an assumed span long matches of unbounded filters can be missed. */
+    BOOST_CHECK(filter->matches(input, input, 1024, 16) == false);
+
+    input = std::string(1020, 'a') + "<abc>" + std::string(5000, 'a');
+    BOOST_CHECK(filter->matches(input, input, 1024, 16) == true);
+
+    /* Word boundaries at the end of a window see the next character. */
+    filter->set_regex("alert\\b");
+    BOOST_CHECK(filter->get_max_span() == 5);
+
+    input = std::string(1024, 'a') + "alertx" + std::string(5000, 'a');
+    BOOST_CHECK(filter->matches(input, input, 1024) == false);
+
+    input = std::string(1024, 'a') + "alert " + std::string(5000, 'a');
+    BOOST_CHECK(filter->matches(input, input, 1024) == true);
+
+    /* Buffer anchors only match at the start of the input, not of a window. */
+    filter->set_regex("\\Afoo");
+
+    input = std::string(1024, 'a') + "foo" + std::string(5000, 'a');
+    BOOST_CHECK(filter->matches(input, input, 1024) == false);
+
+    input = "foo" + std::string(6000, 'a');
+    BOOST_CHECK(filter->matches(input, input, 1024) == true);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -178,4 +178,146 @@ BOOST_AUTO_TEST_CASE(positive_blacklist_check_limit_by_rule) {
     BOOST_CHECK(parameter->is_threat() == true);
 }
 
+BOOST_AUTO_TEST_CASE(memoized_blacklist_check) {
+    swd::cache_ptr cache(new swd::cache(swd::database_ptr()));
+    cache->get_scan_memo()->set_capacity(1024);
+    swd::blacklist blacklist(cache);
+
+    swd::profile_ptr profile(new swd::profile);
+    profile->set_id(1);
+    profile->set_blacklist_threshold(5);
+
+    swd::blacklist_filter_ptr filter(new swd::blacklist_filter);
+    filter->set_impact(6);
+    filter->set_regex("foo");
+
+    swd::blacklist_filters filters;
+    filters.push_back(filter);
+    cache->set_blacklist_filters(filters);
+    cache->add_blacklist_rules(1, "qux", "bar", swd::blacklist_rules());
+
+    for (int i = 0; i < 2; i++) {
+        swd::request_ptr request(new swd::request);
+        request->set_caller("qux");
+        request->set_profile(profile);
+        swd::parameter_ptr parameter(new swd::parameter);
+        parameter->set_path("bar");
+        parameter->set_value("foo");
+        request->add_parameter(parameter);
+
+        blacklist.scan(request);
+        BOOST_CHECK(parameter->get_blacklist_filters().size() == 1);
+    }
+
+    BOOST_CHECK(cache->get_scan_memo()->get_size() == 2);
+
+    /* New filters must not use the remembered results. */
+    filter.reset(new swd::blacklist_filter);
+    filter->set_impact(6);
+    filter->set_regex("baz");
+
+    filters.clear();
+    filters.push_back(filter);
+    cache->set_blacklist_filters(filters);
+
+    swd::request_ptr request(new swd::request);
+    request->set_caller("qux");
+    request->set_profile(profile);
+    swd::parameter_ptr parameter(new swd::parameter);
+    parameter->set_path("bar");
+    parameter->set_value("foo");
+    request->add_parameter(parameter);
+
+    blacklist.scan(request);
+    BOOST_CHECK(parameter->get_blacklist_filters().size() == 0);
+}
+
+BOOST_AUTO_TEST_CASE(early_terminated_blacklist_check) {
+    swd::cache_ptr cache(new swd::cache(swd::database_ptr()));
+    cache->get_scan_memo()->set_capacity(1024);
+
+    swd::profile_ptr profile(new swd::profile);
+    profile->set_id(1);
+    profile->set_mode(MODE_ACTIVE);
+    profile->set_blacklist_threshold(5);
+
+    swd::blacklist_filters filters;
+
+    for (const auto& regex: {"fo", "oo", "foo"}) {
+        swd::blacklist_filter_ptr filter(new swd::blacklist_filter);
+        filter->set_impact(6);
+        filter->set_regex(regex);
+        filters.push_back(filter);
+    }
+
+    cache->set_blacklist_filters(filters);
+    cache->add_blacklist_rules(1, "qux", "bar", swd::blacklist_rules());
+
+    for (bool full_scan: {false, true}) {
+        swd::blacklist blacklist(cache, full_scan);
+
+        swd::request_ptr request(new swd::request);
+        request->set_caller("qux");
+        request->set_profile(profile);
+        swd::parameter_ptr parameter(new swd::parameter);
+        parameter->set_path("bar");
+        parameter->set_value("foo");
+        request->add_parameter(parameter);
+
+        blacklist.scan(request);
+        BOOST_CHECK(parameter->get_blacklist_filters().size() == (full_scan ? 3 : 1));
+        BOOST_CHECK(parameter->is_threat() == true);
+    }
+
+    /* Only the results of the full scan are complete and remembered. */
+    BOOST_CHECK(cache->get_scan_memo()->get_size() == 2);
+
+    /* The order is sorted once and shared by the following requests. */
+    swd::blacklist_filter_set_ptr filter_set = cache->get_blacklist_filter_set();
+    BOOST_CHECK(filter_set->get_order()->size() == 3);
+    BOOST_CHECK(filter_set->get_order() == filter_set->get_order());
+}
+
+BOOST_AUTO_TEST_CASE(disabled_tags_blacklist_check) {
+    swd::cache_ptr cache(new swd::cache(swd::database_ptr()));
+    swd::blacklist blacklist(cache);
+
+    swd::blacklist_filters filters;
+
+    for (unsigned long long tag_id: {1, 2}) {
+        swd::blacklist_filter_ptr filter(new swd::blacklist_filter);
+        filter->set_impact(6);
+        filter->set_regex("foo");
+        filter->add_tag(tag_id);
+        filter->add_tag(3);
+        filters.push_back(filter);
+    }
+
+    cache->set_blacklist_filters(filters);
+    cache->add_blacklist_rules(1, "qux", "bar", swd::blacklist_rules());
+
+    /* Profiles that disable the same tags share the subset. */
+    BOOST_CHECK(cache->get_blacklist_filter_set({2})->get_filters().size() == 1);
+    BOOST_CHECK(cache->get_blacklist_filter_set({2}) == cache->get_blacklist_filter_set({2}));
+    BOOST_CHECK(cache->get_blacklist_filter_set({3})->get_filters().size() == 0);
+    BOOST_CHECK(cache->get_blacklist_filter_set({}) == cache->get_blacklist_filter_set());
+
+    swd::profile_ptr profile(new swd::profile);
+    profile->set_id(1);
+    profile->set_blacklist_threshold(5);
+    profile->add_disabled_tag(1);
+
+    swd::request_ptr request(new swd::request);
+    request->set_caller("qux");
+    request->set_profile(profile);
+    swd::parameter_ptr parameter(new swd::parameter);
+    parameter->set_path("bar");
+    parameter->set_value("foo");
+    request->add_parameter(parameter);
+
+    blacklist.scan(request);
+    BOOST_CHECK(parameter->get_blacklist_filters().size() == 1);
+    BOOST_CHECK(parameter->get_blacklist_filters()[0] == filters[1]);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
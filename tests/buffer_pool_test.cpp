@@ -0,0 +1,66 @@
+/**
+ * Shadow Daemon -- Web Application Firewall
+ *
+ *   Copyright (C) 2014-2022 Hendrik Buchwald <hb@zecure.org>
+ *
+ * This file is part of Shadow Daemon. Shadow Daemon is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, version 2.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include "buffer_pool.h"
+
+BOOST_AUTO_TEST_SUITE(buffer_pool_test)
+
+BOOST_AUTO_TEST_CASE(reuse_buffer) {
+    swd::buffer_pool buffer_pool;
+
+    swd::buffer_ptr buffer = buffer_pool.acquire();
+    BOOST_CHECK(buffer);
+    BOOST_CHECK(buffer_pool.get_idle() == 0);
+
+    buffer_pool.release(buffer);
+    BOOST_CHECK(buffer_pool.get_idle() == 1);
+
+    BOOST_CHECK(buffer_pool.acquire() == buffer);
+    BOOST_CHECK(buffer_pool.get_idle() == 0);
+}
+
+BOOST_AUTO_TEST_CASE(limit_idle_buffers) {
+    swd::buffer_pool buffer_pool(1);
+
+    swd::buffer_ptr buffer1 = buffer_pool.acquire();
+    swd::buffer_ptr buffer2 = buffer_pool.acquire();
+    BOOST_CHECK(buffer1 != buffer2);
+
+    buffer_pool.release(buffer1);
+    buffer_pool.release(buffer2);
+    buffer_pool.release(swd::buffer_ptr());
+    BOOST_CHECK(buffer_pool.get_idle() == 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,104 @@
+/**
+ * Shadow Daemon -- Web Application Firewall
+ *
+ *   Copyright (C) 2014-2022 Hendrik Buchwald <hb@zecure.org>
+ *
+ * This file is part of Shadow Daemon. Shadow Daemon is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, version 2.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include <boost/regex.hpp>
+
+#include "case_fold.h"
+#include "blacklist_filter.h"
+
+BOOST_AUTO_TEST_SUITE(case_fold_test)
+
+BOOST_AUTO_TEST_CASE(fold) {
+    std::string output;
+
+    swd::case_fold::fold("SELECT * FROM Users WHERE @x=[Z]", output);
+    BOOST_CHECK(output == "select * from users where @x=[z]");
+
+    swd::case_fold::fold(std::string("A\0\xc3\x84", 4), output);
+    BOOST_CHECK(output == std::string("a\0\xc3\x84", 4));
+
+    swd::case_fold::fold("", output);
+    BOOST_CHECK(output.empty());
+}
+
+BOOST_AUTO_TEST_CASE(fold_regex) {
+    std::string output;
+
+    BOOST_CHECK(swd::case_fold::fold_regex("SELECT\\s+\\S", output) == true);
+    BOOST_CHECK(output == "select\\s+\\S");
+
+    BOOST_CHECK(swd::case_fold::fold_regex("[A-Z0-9_]+(?:Foo|\\bBar)", output) == true);
+    BOOST_CHECK(output == "[a-z0-9_]+(?:foo|\\bbar)");
+
+    std::string unfoldable[] = {"\\x41", "(?i)a", "[0-Z]", "[[:upper:]]", "\\QA\\E", "\\p{Lu}",
+     "\\0101", "[\\0101]", "\\101", "\\12"};
+
+    for (const auto& regex: unfoldable) {
+        BOOST_CHECK_MESSAGE(swd::case_fold::fold_regex(regex, output) == false, regex);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(fold_regex_equivalence) {
+    std::string regexes[] = {"Foo[A-C]", "(A)\\1", "\\bSELECT\\s+\\w", "[^X-Z]{2}", "\\0101", "\\x41"};
+    std::string inputs[] = {"a", "A", "ABC", "aa", "Aa", "fooB", "select x", "xyz", "ab"};
+
+    for (const auto& regex: regexes) {
+        boost::regex original(regex, boost::regex::icase | boost::regex::mod_s);
+        std::string folded_regex;
+
+        if (!swd::case_fold::fold_regex(regex, folded_regex)) {
+            continue;
+        }
+
+        boost::regex folded(folded_regex, boost::regex::mod_s);
+
+        for (const auto& input: inputs) {
+            std::string folded_input;
+            swd::case_fold::fold(input, folded_input);
+
+            BOOST_CHECK_MESSAGE(boost::regex_search(folded_input, original) ==
+             boost::regex_search(folded_input, folded), regex + " / " + input);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(folded_filter) {
+    swd::blacklist_filter_ptr filter(new swd::blacklist_filter());
+    filter->set_regex("Foo[A-C]");
+
+    BOOST_CHECK(filter->matches("xfOOb") == true);
+    BOOST_CHECK(filter->matches("xFOOB") == true);
+    BOOST_CHECK(filter->matches("xfood") == false);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
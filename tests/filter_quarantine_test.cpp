@@ -0,0 +1,138 @@
+/**
+ * Shadow Daemon -- Web Application Firewall
+ *
+ *   Copyright (C) 2014-2022 Hendrik Buchwald <hb@zecure.org>
+ *
+ * This file is part of Shadow Daemon. Shadow Daemon is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, version 2.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include "filter_quarantine.h"
+#include "blacklist.h"
+
+BOOST_AUTO_TEST_SUITE(filter_quarantine_test)
+
+BOOST_AUTO_TEST_CASE(filter_stats) {
+    swd::filter_stats stats;
+    BOOST_CHECK(stats.get_average_nanoseconds() == 0);
+
+    stats.add_evaluation(100, false);
+    stats.add_evaluation(300, true);
+    stats.add_abort(800);
+
+    BOOST_CHECK(stats.get_evaluations() == 3);
+    BOOST_CHECK(stats.get_matches() == 2);
+    BOOST_CHECK(stats.get_aborts() == 1);
+    BOOST_CHECK(stats.get_nanoseconds() == 1200);
+    BOOST_CHECK(stats.get_average_nanoseconds() == 400);
+
+    BOOST_CHECK(stats.quarantine() == true);
+    BOOST_CHECK(stats.quarantine() == false);
+    BOOST_CHECK(stats.is_quarantined() == true);
+}
+
+BOOST_AUTO_TEST_CASE(quarantine_slow_filter) {
+    swd::filter_quarantine quarantine;
+    quarantine.set_budget(500, 4);
+
+    swd::filter_stats fast;
+    swd::filter_stats slow;
+
+    for (int i = 0; i < 1000; i++) {
+        fast.add_evaluation(100, false);
+        slow.add_evaluation(1000, false);
+    }
+
+    quarantine.check(1, fast);
+    quarantine.check(2, slow);
+    BOOST_CHECK(fast.is_quarantined() == false);
+    BOOST_CHECK(slow.is_quarantined() == true);
+
+    /* Quarantined filters are evaluated for every 4th input only. */
+    int evaluated = 0;
+
+    for (int i = 0; i < 8; i++) {
+        BOOST_CHECK(quarantine.skip(fast) == false);
+
+        if (!quarantine.skip(slow)) {
+            evaluated++;
+        }
+    }
+
+    BOOST_CHECK(evaluated == 2);
+    BOOST_CHECK(slow.get_quarantined_inputs() == 8);
+}
+
+BOOST_AUTO_TEST_CASE(disabled_quarantine) {
+    swd::filter_quarantine quarantine;
+
+    swd::filter_stats slow;
+
+    for (int i = 0; i < 1000; i++) {
+        slow.add_evaluation(1000000, false);
+    }
+
+    quarantine.check(1, slow);
+    BOOST_CHECK(slow.is_quarantined() == false);
+}
+
+BOOST_AUTO_TEST_CASE(blacklist_filter_stats) {
+    swd::cache_ptr cache(new swd::cache(swd::database_ptr()));
+    swd::blacklist blacklist(cache);
+
+    swd::request_ptr request(new swd::request);
+    request->set_caller("qux");
+    swd::parameter_ptr parameter(new swd::parameter);
+    parameter->set_path("bar");
+    parameter->set_value("foo'");
+    request->add_parameter(parameter);
+
+    swd::blacklist_filter_ptr filter(new swd::blacklist_filter);
+    filter->set_impact(6);
+    filter->set_regex("foo");
+
+    swd::blacklist_filters filters;
+    filters.push_back(filter);
+    cache->set_blacklist_filters(filters);
+
+    swd::blacklist_rules rules;
+    cache->add_blacklist_rules(1, "qux", "bar", rules);
+
+    swd::profile_ptr profile(new swd::profile);
+    profile->set_id(1);
+    profile->set_blacklist_threshold(5);
+    request->set_profile(profile);
+
+    blacklist.scan(request);
+
+    /* The value and the path are tested. */
+    BOOST_CHECK(filter->get_stats().get_evaluations() == 2);
+    BOOST_CHECK(filter->get_stats().get_matches() == 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
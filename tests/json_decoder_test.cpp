@@ -0,0 +1,128 @@
+/**
+ * Shadow Daemon -- Web Application Firewall
+ *
+ *   Copyright (C) 2014-2022 Hendrik Buchwald <hb@zecure.org>
+ *
+ * This file is part of Shadow Daemon. Shadow Daemon is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, version 2.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include "json_decoder.h"
+#include "shared.h"
+
+BOOST_AUTO_TEST_SUITE(json_decoder_test)
+
+BOOST_AUTO_TEST_CASE(valid_decode) {
+    swd::request_ptr request(new swd::request);
+    swd::json_decoder json_decoder(request);
+
+    BOOST_CHECK(json_decoder.decode("{\"version\":\"2.0.0\",\"client_ip\":\"127.0.0.1\","
+     "\"caller\":\"foo\",\"resource\":\"\\/bar.php\",\"extra\":[1,{\"a\":null},true],"
+     "\"input\":{\"GET|a\":\"b\\u00e4\\\"c\",\"GET|n\":42,\"GET|e\":null},"
+     "\"hashes\":{\"sha256\":\"abc\"}}") == STATUS_OK);
+
+    BOOST_CHECK(request->get_client_ip() == "127.0.0.1");
+    BOOST_CHECK(request->get_caller() == "foo");
+    BOOST_CHECK(request->get_resource() == "/bar.php");
+    BOOST_CHECK(request->get_parameters().size() == 3);
+    BOOST_CHECK(request->get_parameters()[0]->get_path() == "GET|a");
+    BOOST_CHECK(request->get_parameters()[0]->get_value() == "b\xc3\xa4\"c");
+    BOOST_CHECK(request->get_parameters()[1]->get_value() == "42");
+    BOOST_CHECK(request->get_parameters()[2]->get_value() == "");
+    BOOST_CHECK(request->get_hash("sha256")->get_digest() == "abc");
+}
+
+BOOST_AUTO_TEST_CASE(invalid_decode) {
+    std::string inputs[] = {
+        "",
+        "{\"client_ip\":\"\",\"input\":{},\"hashes\":{}",
+        "{\"client_ip\":\"\",\"input\":{},\"hashes\":{}} x",
+        "{\"client_ip\":null,\"input\":{},\"hashes\":{}}",
+        "{\"client_ip\":\"\",\"input\":{\"a\":\"\\ud800\"},\"hashes\":{}}",
+        "{\"client_ip\":\"\",\"input\":{},\"hashes\":{},\"x\":" + std::string(1000, '[') + "}"
+    };
+
+    for (const auto& input: inputs) {
+        swd::request_ptr request(new swd::request);
+        swd::json_decoder json_decoder(request);
+
+        BOOST_CHECK(json_decoder.decode(input) == STATUS_BAD_JSON);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(nested_values) {
+    swd::request_ptr request(new swd::request);
+    swd::json_decoder json_decoder(request);
+
+    BOOST_CHECK(json_decoder.decode("{\"client_ip\":\"\",\"input\":{\"a\":[1,{\"b\":2}],"
+     "\"c\":\"d\",\"e\":{}},\"hashes\":{\"sha1\":[],\"sha256\":\"abc\"}}") == STATUS_OK);
+
+    BOOST_CHECK(request->get_parameters().size() == 1);
+    BOOST_CHECK(request->get_parameters()[0]->get_path() == "c");
+    BOOST_CHECK(request->get_hashes().size() == 1);
+    BOOST_CHECK(json_decoder.get_skipped() == std::vector<std::string>({"a", "e", "sha1"}));
+}
+
+BOOST_AUTO_TEST_CASE(duplicate_keys) {
+    swd::request_ptr request(new swd::request);
+    swd::json_decoder json_decoder(request, 2);
+
+    BOOST_CHECK(json_decoder.decode("{\"client_ip\":\"\",\"input\":{\"a\":\"1\",\"b\":\"2\"},"
+     "\"hashes\":{\"sha1\":\"abc\"},\"input\":{\"c\":\"3\"},\"hashes\":{\"sha256\":\"def\"}}") == STATUS_OK);
+
+    BOOST_CHECK(request->get_parameters().size() == 1);
+    BOOST_CHECK(request->get_parameters()[0]->get_path() == "c");
+    BOOST_CHECK(!request->get_hash("sha1"));
+    BOOST_CHECK(request->get_hash("sha256")->get_digest() == "def");
+}
+
+BOOST_AUTO_TEST_CASE(limits) {
+    std::string content = "{\"client_ip\":\"\",\"input\":{\"a\":\"12345\",\"bcd\":\"1\"},\"hashes\":{}}";
+
+    swd::request_ptr request1(new swd::request);
+    swd::json_decoder json_decoder1(request1, 1, -1, -1);
+    BOOST_CHECK(json_decoder1.decode(content) == STATUS_BAD_REQUEST);
+    BOOST_CHECK(json_decoder1.get_message() == "Too many parameters");
+    BOOST_CHECK(request1->get_parameters().size() == 1);
+
+    swd::request_ptr request2(new swd::request);
+    swd::json_decoder json_decoder2(request2, -1, 2, -1);
+    BOOST_CHECK(json_decoder2.decode(content) == STATUS_BAD_REQUEST);
+    BOOST_CHECK(json_decoder2.get_message() == "Too long parameter path");
+
+    swd::request_ptr request3(new swd::request);
+    swd::json_decoder json_decoder3(request3, -1, -1, 4);
+    BOOST_CHECK(json_decoder3.decode(content) == STATUS_BAD_REQUEST);
+    BOOST_CHECK(json_decoder3.get_message() == "Too long parameter value");
+
+    swd::request_ptr request4(new swd::request);
+    swd::json_decoder json_decoder4(request4, 2, 3, 5);
+    BOOST_CHECK(json_decoder4.decode(content) == STATUS_OK);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,65 @@
+/**
+ * Shadow Daemon -- Web Application Firewall
+ *
+ *   Copyright (C) 2014-2022 Hendrik Buchwald <hb@zecure.org>
+ *
+ * This file is part of Shadow Daemon. Shadow Daemon is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, version 2.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include "match_span.h"
+
+BOOST_AUTO_TEST_SUITE(match_span_test)
+
+BOOST_AUTO_TEST_CASE(bounded) {
+    std::pair<std::string, long> lengths[] = {
+        {"", 0}, {"foo", 3}, {"^foo$", 3}, {"\\bor\\b", 2}, {"a|bcd", 3}, {"(?:ab|c)d", 3},
+        {"[^<>]x", 2}, {"[[:alpha:]]", 1}, {"[\\]]", 1}, {"a?", 1}, {"\\d{2,4}", 4},
+        {"x{3}", 3}, {"(?:ab){2}c", 5}, {"a{", 2}, {"\\x3c\\s", 2}, {"(?i)union", 5},
+        {"(?=<)a", 2}, {"(?<!\\w)on", 3}, {"a{0}", 0}, {"a{1,3}?", 3},
+        {"[[=a=]]", 1}, {"[[.].]]", 1}
+    };
+
+    for (const auto& length: lengths) {
+        BOOST_CHECK_MESSAGE(swd::match_span::get_max_length(length.first) == length.second,
+         length.first);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(unbounded) {
+    std::string regexes[] = {"a*", "a+", "x{2,}", "(a)\\1", "(", "a)", "[ab", "*a",
+     "\\p{L}", "(?:a{1000}){2000}", "(?:<.*?>|x)",
+     "(?x) a b", "(?x: a )"};
+
+    for (const auto& regex: regexes) {
+        BOOST_CHECK_MESSAGE(swd::match_span::get_max_length(regex) == swd::match_span::UNBOUNDED,
+         regex);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
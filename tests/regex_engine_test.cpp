@@ -0,0 +1,115 @@
+/**
+ * Shadow Daemon -- Web Application Firewall
+ *
+ *   Copyright (C) 2014-2022 Hendrik Buchwald <hb@zecure.org>
+ *
+ * This file is part of Shadow Daemon. Shadow Daemon is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, version 2.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include <stdexcept>
+
+#include "regex_engine.h"
+
+BOOST_AUTO_TEST_SUITE(regex_engine_test)
+
+BOOST_AUTO_TEST_CASE(engines) {
+    for (const auto& type: swd::regex_engine::get_types()) {
+        BOOST_TEST_MESSAGE(type);
+
+        swd::regex_engine_ptr regex = swd::regex_engine::compile(type, "a.c", false);
+        BOOST_CHECK(regex->search("xa\nc") == true);
+        BOOST_CHECK(regex->search("xA\nc") == false);
+
+        regex = swd::regex_engine::compile(type, "\\bunion\\s+select\\b", true);
+        BOOST_CHECK(regex->search("1 UNION  Select 2") == true);
+        BOOST_CHECK(regex->search("1 unionselect 2") == false);
+
+        regex = swd::regex_engine::compile(type, "<\\x00>", false);
+        BOOST_CHECK(regex->search(std::string("a<\0>b", 5)) == true);
+
+        BOOST_CHECK_THROW(swd::regex_engine::compile(type, "(a", false), std::runtime_error);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(line_anchors) {
+    /* Like in boost the anchors also match at line breaks. */
+    for (const auto& type: swd::regex_engine::get_types()) {
+        BOOST_TEST_MESSAGE(type);
+
+        swd::regex_engine_ptr regex = swd::regex_engine::compile(type, "^(\\s*)\\||\\|(\\s*)$", false);
+        BOOST_CHECK(regex->search("foo\n| ls") == true);
+        BOOST_CHECK(regex->search("foo |\nbar") == true);
+        BOOST_CHECK(regex->search("foo | bar") == false);
+
+        regex = swd::regex_engine::compile(type, "^b", false);
+        BOOST_CHECK(regex->search("a\nb") == true);
+        BOOST_CHECK(regex->search("ab") == false);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(windows) {
+    for (const auto& type: swd::regex_engine::get_types()) {
+        BOOST_TEST_MESSAGE(type);
+
+        swd::regex_engine_ptr regex = swd::regex_engine::compile(type, "foo", false);
+        BOOST_CHECK(regex->search("xxfooxx", 2, 5) == true);
+        BOOST_CHECK(regex->search("xxfooxx", 3, 7) == false);
+        BOOST_CHECK(regex->search("xxfooxx", 0, 4) == false);
+
+        /* The end of a window is not the end of the input. */
+        regex = swd::regex_engine::compile(type, "foo$", false);
+        BOOST_CHECK(regex->search("xxfooxx", 0, 5) == false);
+        BOOST_CHECK(regex->search("xxfoo", 0, 5) == true);
+
+        /* The start of a window is not the start of the input. */
+        regex = swd::regex_engine::compile(type, "\\Afoo", false);
+        BOOST_CHECK(regex->search("xxxxfoo", 4, 7) == false);
+        BOOST_CHECK(regex->search("fooxxxx", 0, 4) == true);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(unavailable_engine) {
+    BOOST_CHECK(swd::regex_engine::is_available("boost") == true);
+    BOOST_CHECK(swd::regex_engine::is_available("foo") == false);
+    BOOST_CHECK_THROW(swd::regex_engine::compile("foo", "a", false), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(default_engine_fallback) {
+    for (const auto& type: swd::regex_engine::get_types()) {
+        swd::regex_engine::set_default_type(type);
+
+        /* RE2 does not support lookarounds, so boost has to step in. */
+        swd::regex_engine_ptr regex = swd::regex_engine::compile("foo(?!bar)", false);
+        BOOST_CHECK(regex->search("foobaz") == true);
+        BOOST_CHECK(regex->search("foobar") == false);
+    }
+
+    swd::regex_engine::set_default_type("boost");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -32,6 +32,8 @@
 #define BOOST_TEST_DYN_LINK
 #include <boost/test/unit_test.hpp>
 
+#include <json/json.h>
+
 #include "reply_handler.h"
 
 BOOST_AUTO_TEST_SUITE(reply_handler_test)
@@ -60,4 +62,57 @@ BOOST_AUTO_TEST_CASE(encode_attack) {
     BOOST_CHECK(reply->get_content() == "{\"status\":5,\"threats\":[\"foo\",\"bar\"]}\n");
 }
 
+BOOST_AUTO_TEST_CASE(encode_prebuilt) {
+    swd::reply_ptr reply(new swd::reply);
+    swd::reply_handler reply_handler(reply);
+
+    reply->set_status(STATUS_BAD_SIGNATURE);
+
+    BOOST_CHECK(reply_handler.encode() == true);
+    BOOST_CHECK(reply->to_buffers().size() == 1);
+    BOOST_CHECK(reply->get_content() == "{\"status\":3,\"threats\":[]}\n");
+
+    reply->set_status(STATUS_OVERLOADED);
+
+    BOOST_CHECK(reply_handler.encode() == true);
+    BOOST_CHECK(reply->to_buffers().size() == 1);
+    BOOST_CHECK(reply->get_content() == "{\"status\":7,\"threats\":[]}\n");
+}
+
+BOOST_AUTO_TEST_CASE(encode_escaped) {
+    swd::reply_ptr reply(new swd::reply);
+    swd::reply_handler reply_handler(reply);
+
+    std::vector<std::string> threats;
+    threats.push_back("foo");
+    threats.push_back(std::string("b\"a\\r\n\x01\0\xc3\xa4", 10));
+    reply->set_threats(threats);
+    reply->set_message("Bad \"request\"");
+    reply->set_status(STATUS_BAD_REQUEST);
+
+    BOOST_CHECK(reply_handler.encode() == true);
+
+    /* The output has to be identical to the output of jsoncpp. */
+    Json::Value root;
+    Json::FastWriter writer;
+
+    root["status"] = STATUS_BAD_REQUEST;
+    root["message"] = reply->get_message();
+    root["threats"] = Json::Value(Json::arrayValue);
+
+    for (const auto& threat: threats) {
+        root["threats"].append(threat);
+    }
+
+    BOOST_CHECK(reply->get_content() == writer.write(root));
+
+    /* The reply is reusable. */
+    reply->set_threats(std::vector<std::string>());
+    reply->set_message("");
+    reply->set_status(STATUS_OK);
+
+    BOOST_CHECK(reply_handler.encode() == true);
+    BOOST_CHECK(reply->get_content() == "{\"status\":1,\"threats\":[]}\n");
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -32,6 +32,8 @@
 #define BOOST_TEST_DYN_LINK
 #include <boost/test/unit_test.hpp>
 
+#include <zlib.h>
+
 #include "request_handler.h"
 
 BOOST_AUTO_TEST_SUITE(request_handler_test)
@@ -64,30 +66,122 @@ BOOST_AUTO_TEST_CASE(invalid_signature) {
     BOOST_CHECK(request_handler.valid_signature() == false);
 }
 
+BOOST_AUTO_TEST_CASE(cached_signature) {
+    swd::request_ptr request(new swd::request);
+    swd::cache_ptr cache(new swd::cache(swd::database_ptr()));
+    swd::request_handler request_handler(request, cache, swd::storage_ptr());
+    swd::profile_ptr profile(new swd::profile);
+
+    profile->set_id(1);
+    profile->set_key("foo");
+    request->set_profile(profile);
+    request->set_signature("F9320BAF0249169E73850CD6156DED0106E2BB6AD8CAB01B7BBBEBE6D1065317");
+    request->set_content("bar");
+
+    /* The second check uses the cached key. */
+    BOOST_CHECK(request_handler.valid_signature() == true);
+    BOOST_CHECK(request_handler.valid_signature() == true);
+
+    /* A changed key must not be served from the cache. */
+    profile->set_key("qux");
+    BOOST_CHECK(request_handler.valid_signature() == false);
+
+    request->set_signature("f9320baf0249169e73850cd6156ded0106e2bb6ad8cab01b7bbbebe6d106531");
+    profile->set_key("foo");
+    BOOST_CHECK(request_handler.valid_signature() == false);
+}
+
 BOOST_AUTO_TEST_CASE(valid_decode) {
     swd::request_ptr request(new swd::request);
     swd::request_handler request_handler(request, swd::cache_ptr(), swd::storage_ptr());
 
     request->set_content("{\"version\":\"2.0.0-php\",\"client_ip\":\"127.0.0.1\",\"caller\":"
      "\"foo\",\"resource\":\"\\/bar.php\",\"input\":{\"foo\":\"bar\"},\"hashes\":{\"foo\":\"bar\"}}");
-    BOOST_CHECK(request_handler.decode() == true);
+    BOOST_CHECK(request_handler.decode() == STATUS_OK);
 }
 
 BOOST_AUTO_TEST_CASE(invalid_decode) {
     swd::request_ptr request(new swd::request);
     swd::request_handler request_handler(request, swd::cache_ptr(), swd::storage_ptr());
 
-    BOOST_CHECK(request_handler.decode() == false);
+    BOOST_CHECK(request_handler.decode() == STATUS_BAD_JSON);
 
     request->set_content("{}");
-    BOOST_CHECK(request_handler.decode() == false);
+    BOOST_CHECK(request_handler.decode() == STATUS_BAD_JSON);
 
     request->set_content("[]");
-    BOOST_CHECK(request_handler.decode() == false);
+    BOOST_CHECK(request_handler.decode() == STATUS_BAD_JSON);
 
     request->set_content("{\"version\":{},\"client_ip\":{},\"caller\":{},\"resource\":{},"
      "\"input\":[],\"hashes\":[]}");
-    BOOST_CHECK(request_handler.decode() == false);
+    BOOST_CHECK(request_handler.decode() == STATUS_BAD_JSON);
+}
+
+BOOST_AUTO_TEST_CASE(limited_decode) {
+    swd::request_ptr request(new swd::request);
+    swd::request_handler request_handler(request, swd::cache_ptr(), swd::storage_ptr());
+    request_handler.set_limits(1, -1, -1);
+
+    request->set_content("{\"version\":\"2.0.0-php\",\"client_ip\":\"127.0.0.1\",\"caller\":"
+     "\"foo\",\"resource\":\"\\/bar.php\",\"input\":{\"foo\":\"bar\",\"bar\":\"foo\"},\"hashes\":{}}");
+    BOOST_CHECK(request_handler.decode() == STATUS_BAD_REQUEST);
+    BOOST_CHECK(request_handler.get_message() == "Too many parameters");
+}
+
+BOOST_AUTO_TEST_CASE(compressed_decode) {
+    std::string content = "{\"version\":\"2.0.0-php\",\"client_ip\":\"127.0.0.1\",\"caller\":"
+     "\"foo\",\"resource\":\"\\/bar.php\",\"input\":{\"foo\":\"" + std::string(1000, 'a') +
+     "\"},\"hashes\":{}}";
+
+    uLongf length = compressBound(content.size());
+    std::string compressed(length, '\0');
+    compress((Bytef *)&compressed[0], &length, (const Bytef *)content.data(), content.size());
+    compressed.resize(length);
+
+    swd::request_ptr request(new swd::request);
+    swd::request_handler request_handler(request, swd::cache_ptr(), swd::storage_ptr());
+
+    request->set_content(compressed);
+    request->set_compressed(true);
+    BOOST_CHECK(request_handler.decode() == STATUS_OK);
+    BOOST_CHECK(request->get_content() == content);
+    BOOST_CHECK(request->get_parameters().size() == 1);
+
+    /* Decompression bombs are stopped at the limit. */
+    swd::request_ptr bomb(new swd::request);
+    swd::request_handler bomb_handler(bomb, swd::cache_ptr(), swd::storage_ptr());
+    bomb_handler.set_limits(-1, -1, -1, 100);
+
+    bomb->set_content(compressed);
+    bomb->set_compressed(true);
+    BOOST_CHECK(bomb_handler.decode() == STATUS_BAD_REQUEST);
+    BOOST_CHECK(bomb_handler.get_message() == "Too long inflated content");
+
+    /* Content with exactly the maximum length is still accepted. */
+    swd::request_ptr exact(new swd::request);
+    swd::request_handler exact_handler(exact, swd::cache_ptr(), swd::storage_ptr());
+    exact_handler.set_limits(-1, -1, -1, content.size());
+
+    exact->set_content(compressed);
+    exact->set_compressed(true);
+    BOOST_CHECK(exact_handler.decode() == STATUS_OK);
+
+    swd::request_ptr above(new swd::request);
+    swd::request_handler above_handler(above, swd::cache_ptr(), swd::storage_ptr());
+    above_handler.set_limits(-1, -1, -1, content.size() - 1);
+
+    above->set_content(compressed);
+    above->set_compressed(true);
+    BOOST_CHECK(above_handler.decode() == STATUS_BAD_REQUEST);
+    BOOST_CHECK(above_handler.get_message() == "Too long inflated content");
+
+    /* Corrupt and truncated streams are bad json. */
+    swd::request_ptr corrupt(new swd::request);
+    swd::request_handler corrupt_handler(corrupt, swd::cache_ptr(), swd::storage_ptr());
+
+    corrupt->set_content(compressed.substr(0, compressed.size() / 2));
+    corrupt->set_compressed(true);
+    BOOST_CHECK(corrupt_handler.decode() == STATUS_BAD_JSON);
 }
 
 BOOST_AUTO_TEST_CASE(nullbyte_decode) {
@@ -96,7 +190,7 @@ BOOST_AUTO_TEST_CASE(nullbyte_decode) {
 
     request->set_content("{\"version\":\"\",\"client_ip\":\"\",\"caller\":\"\",\"resource\":"
      "\"foo\\u0000bar\",\"input\":{},\"hashes\":{}}");
-    BOOST_CHECK(request_handler.decode() == true);
+    BOOST_CHECK(request_handler.decode() == STATUS_OK);
 
     std::stringstream expected;
     expected << "foo" << '\0' << "bar";
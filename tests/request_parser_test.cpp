@@ -148,4 +148,99 @@ BOOST_AUTO_TEST_CASE(invalid_parse_hmac) {
     BOOST_CHECK((bool)result == false);
 }
 
+BOOST_AUTO_TEST_CASE(chunked_parse) {
+    swd::request_ptr request(new swd::request);
+
+    std::string input = "13\nabc123\n{\"foo\": \"bar\"}\n";
+
+    /* Feed the input in chunks of three characters, like a slow client. */
+    swd::request_parser parser;
+    boost::tribool result = boost::indeterminate;
+
+    for (std::size_t i = 0; (i < input.length()) && indeterminate(result); i += 3) {
+        std::size_t length = std::min<std::size_t>(3, input.length() - i);
+
+        boost::tie(result, boost::tuples::ignore) =
+            parser.parse(
+                request,
+                input.data() + i,
+                input.data() + i + length
+            );
+    }
+
+    BOOST_CHECK(indeterminate(result) == false);
+    BOOST_CHECK((bool)result == true);
+    BOOST_CHECK(request->get_profile_id() == 13);
+    BOOST_CHECK(request->get_signature() == "abc123");
+    BOOST_CHECK(request->get_content() == "{\"foo\": \"bar\"}");
+}
+
+BOOST_AUTO_TEST_CASE(compressed_parse) {
+    swd::request_ptr request(new swd::request);
+    swd::request_parser parser;
+
+    /* Compressed content might contain line ends. */
+    std::string content("x\n\0y\n", 5);
+    std::string input = "13,5\nabc\n" + content + "\n";
+
+    boost::tribool result = boost::indeterminate;
+
+    for (std::size_t i = 0; (i < input.length()) && indeterminate(result); i++) {
+        boost::tie(result, boost::tuples::ignore) =
+            parser.parse(
+                request,
+                input.data() + i,
+                input.data() + i + 1
+            );
+    }
+
+    BOOST_CHECK(indeterminate(result) == false);
+    BOOST_CHECK((bool)result == true);
+    BOOST_CHECK(request->get_profile_id() == 13);
+    BOOST_CHECK(request->get_signature() == "abc");
+    BOOST_CHECK(request->get_content() == content);
+    BOOST_CHECK(request->is_compressed() == true);
+}
+
+BOOST_AUTO_TEST_CASE(invalid_compressed_parse) {
+    std::string inputs[] = {",5\na\naaaaa\n", "1,\na\na\n", "1,5a\na\naaaaa\n",
+     "1,1234567890\na\na\n", "1,2\na\naaa\n"};
+
+    for (const auto& input: inputs) {
+        swd::request_ptr request(new swd::request);
+        swd::request_parser parser;
+
+        boost::tribool result;
+        boost::tie(result, boost::tuples::ignore) =
+            parser.parse(
+                request,
+                input.data(),
+                input.data() + input.length()
+            );
+
+        BOOST_CHECK(indeterminate(result) == false);
+        BOOST_CHECK((bool)result == false);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(invalid_parse_id_length) {
+    std::string inputs[] = {"\na\na\n", "12345678901234567890\na\na\n", "1\n" + std::string(65, 'a') + "\na\n"};
+
+    for (const auto& input: inputs) {
+        swd::request_ptr request(new swd::request);
+        swd::request_parser parser;
+
+        boost::tribool result;
+        boost::tie(result, boost::tuples::ignore) =
+            parser.parse(
+                request,
+                input.data(),
+                input.data() + input.length()
+            );
+
+        BOOST_CHECK(indeterminate(result) == false);
+        BOOST_CHECK((bool)result == false);
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -53,4 +53,44 @@ BOOST_AUTO_TEST_CASE(has_threats) {
     BOOST_CHECK(request->has_threats() == true);
 }
 
+BOOST_AUTO_TEST_CASE(arena_allocation) {
+    swd::request_ptr request(new swd::request);
+
+    /* More objects than fit into the first block of the arena. */
+    for (int i = 0; i < 1000; i++) {
+        request->add_parameter("path" + std::to_string(i), "value" + std::to_string(i));
+    }
+
+    request->add_hash("sha256", "abc");
+
+    BOOST_CHECK(request->get_parameters().size() == 1000);
+    BOOST_CHECK(request->get_parameters()[999]->get_path() == "path999");
+    BOOST_CHECK(request->get_parameters()[999]->get_value() == "value999");
+    BOOST_CHECK(request->get_hash("sha256")->get_digest() == "abc");
+}
+
+BOOST_AUTO_TEST_CASE(incremental_hmac) {
+    swd::request_ptr request(new swd::request);
+    swd::hmac keyed_hmac((const unsigned char *)"foo", 3);
+
+    /* Start after the first chunk, like the connection does. */
+    std::string chunk1 = "b";
+    std::string chunk2 = "ar";
+    request->append_content(chunk1.data(), chunk1.data() + chunk1.size());
+    request->start_hmac(keyed_hmac, "foo");
+    request->append_content(chunk2.data(), chunk2.data() + chunk2.size());
+
+    BOOST_CHECK(request->has_hmac("foo") == true);
+    BOOST_CHECK(request->has_hmac("qux") == false);
+
+    /* HMAC-SHA256 of "bar" with the key "foo". */
+    const unsigned char mac[] = {
+        0xf9, 0x32, 0x0b, 0xaf, 0x02, 0x49, 0x16, 0x9e, 0x73, 0x85, 0x0c, 0xd6,
+        0x15, 0x6d, 0xed, 0x01, 0x06, 0xe2, 0xbb, 0x6a, 0xd8, 0xca, 0xb0, 0x1b,
+        0x7b, 0xbb, 0xeb, 0xe6, 0xd1, 0x06, 0x53, 0x17
+    };
+
+    BOOST_CHECK(request->verify_hmac(mac) == true);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
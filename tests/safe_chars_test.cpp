@@ -0,0 +1,78 @@
+/**
+ * Shadow Daemon -- Web Application Firewall
+ *
+ *   Copyright (C) 2014-2022 Hendrik Buchwald <hb@zecure.org>
+ *
+ * This file is part of Shadow Daemon. Shadow Daemon is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, version 2.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include "safe_chars.h"
+
+BOOST_AUTO_TEST_SUITE(safe_chars_test)
+
+BOOST_AUTO_TEST_CASE(contains_only) {
+    std::string safe[] = {"", "1", "foo_bar", "3.14", "-1", "123e4567-e89b-12d3-a456-426614174000"};
+    std::string unsafe[] = {"foo bar", "'", "a<b", "1;", std::string("a\0b", 3), "\xc3\xa4"};
+
+    for (const auto& input: safe) {
+        BOOST_CHECK(swd::safe_chars::contains_only(input.data(), input.data() + input.length()) == true);
+    }
+
+    for (const auto& input: unsafe) {
+        BOOST_CHECK(swd::safe_chars::contains_only(input.data(), input.data() + input.length()) == false);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(can_match) {
+    std::string possible[] = {"foo", "\\bsqlite_master\\b", "a|<", "(?:<)?a", "<*", "[^<]",
+     "\\w+", "\\W", "[a-z]", "\\blocation\\b.*?\\..*?\\bhash\\b", "x{0,3}", "(?i)union",
+     "(?=<)", "\\1", "[[:alpha:]]", "(", "a|b<", "\\x41",
+     "(?x) a b", "(?x: a )", "[[=a=]]", "[[.hyphen.]]", "[^[.space.]]"};
+    std::string impossible[] = {"<", "\\(\\)\\s*\\{.*?;\\s*\\}\\s*;", "[\"'].*?>", "(?:a|b)<",
+     "(?:<|>)a", "<+", "[^\\w.-]", "\\s", "x{1,3}<", "a{", "\\x3c", "[<-@]", "[\\]]"};
+
+    for (const auto& regex: possible) {
+        BOOST_CHECK_MESSAGE(swd::safe_chars::can_match(regex) == true, regex);
+    }
+
+    for (const auto& regex: impossible) {
+        BOOST_CHECK_MESSAGE(swd::safe_chars::can_match(regex) == false, regex);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(high_bytes) {
+    /* Bytes above 0x7f are neither letters nor digits, so they are plain literals. */
+    BOOST_CHECK(swd::safe_chars::can_match("\xc3\xa4") == false);
+    BOOST_CHECK(swd::safe_chars::can_match("\\\xe9") == false);
+    BOOST_CHECK(swd::safe_chars::can_match("\\x\xe9") == true);
+    BOOST_CHECK(swd::safe_chars::can_match("(?\xe9)a") == true);
+    BOOST_CHECK(swd::safe_chars::can_match("[\x80-\xff]") == false);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,175 @@
+/**
+ * Shadow Daemon -- Web Application Firewall
+ *
+ *   Copyright (C) 2014-2022 Hendrik Buchwald <hb@zecure.org>
+ *
+ * This file is part of Shadow Daemon. Shadow Daemon is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, version 2.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/make_shared.hpp>
+
+#include "scan_batcher.h"
+#include "blacklist.h"
+
+namespace {
+    swd::blacklist_filter_set_ptr make_filter_set(const std::vector<std::string>& regexes) {
+        swd::blacklist_filters filters;
+
+        for (const auto& regex: regexes) {
+            swd::blacklist_filter_ptr filter(new swd::blacklist_filter);
+            filter->set_impact(6);
+            filter->set_regex(regex);
+            filters.push_back(filter);
+        }
+
+        return boost::make_shared<const swd::blacklist_filter_set>(filters);
+    }
+
+    bool evaluate(const swd::blacklist_filter_ptr& filter, const std::string& input,
+     const std::string& folded, bool& evaluated) {
+        evaluated = true;
+        return filter->matches(input, folded);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(scan_batcher_test)
+
+BOOST_AUTO_TEST_CASE(concurrent_batches) {
+    swd::scan_batcher scan_batcher;
+    scan_batcher.set_limits(100000, 8);
+    BOOST_CHECK(scan_batcher.is_enabled() == true);
+
+    swd::blacklist_filter_set_ptr filter_set = make_filter_set({"<", "foo", "o"});
+    std::string inputs[] = {"foo", "<bar>", "baz", "<foo>"};
+    std::vector<unsigned int> expected[] = {{1, 2}, {0}, {}, {0, 1, 2}};
+
+    /* Every thread adds two strings, so the batches are full after four threads. */
+    bool correct[8];
+    boost::thread_group threads;
+
+    for (int t = 0; t < 8; t++) {
+        threads.create_thread([&, t]() {
+            std::vector<const std::string*> own_inputs = {&inputs[t % 4], &inputs[(t + 1) % 4]};
+            std::vector<std::vector<unsigned int>> matches;
+            std::vector<bool> complete;
+
+            scan_batcher.match(filter_set, own_inputs, {-1, -1}, evaluate, matches, complete);
+
+            correct[t] = (matches.size() == 2) && (matches[0] == expected[t % 4])
+             && (matches[1] == expected[(t + 1) % 4]) && complete[0] && complete[1];
+        });
+    }
+
+    threads.join_all();
+
+    for (int t = 0; t < 8; t++) {
+        BOOST_CHECK(correct[t] == true);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(early_terminated_batches) {
+    swd::scan_batcher scan_batcher;
+    scan_batcher.set_limits(100000, 4);
+
+    swd::blacklist_filter_set_ptr filter_set = make_filter_set({"<", "foo", "o"});
+    std::string inputs[] = {"<foo>", "baz"};
+
+    /**
+     * The strings with a threshold stop after the first match. Both threads
+     * might evaluate a filter at the same time, so there can be one more.
+     */
+    bool correct[2];
+    boost::thread_group threads;
+
+    for (int t = 0; t < 2; t++) {
+        threads.create_thread([&, t]() {
+            std::vector<const std::string*> own_inputs = {&inputs[0], &inputs[1]};
+            std::vector<std::vector<unsigned int>> matches;
+            std::vector<bool> complete;
+
+            scan_batcher.match(filter_set, own_inputs, {(t ? 5 : -1), (t ? 5 : -1)}, evaluate,
+             matches, complete);
+
+            if (t) {
+                correct[t] = !matches[0].empty() && (matches[0].size() < 3) && !complete[0]
+                 && matches[1].empty() && complete[1];
+            } else {
+                correct[t] = (matches[0].size() == 3) && complete[0]
+                 && matches[1].empty() && complete[1];
+            }
+        });
+    }
+
+    threads.join_all();
+
+    BOOST_CHECK(correct[0] == true);
+    BOOST_CHECK(correct[1] == true);
+}
+
+BOOST_AUTO_TEST_CASE(batched_blacklist_check) {
+    swd::cache_ptr cache(new swd::cache(swd::database_ptr()));
+    cache->get_scan_batcher()->set_limits(0, 64);
+    swd::blacklist blacklist(cache);
+
+    swd::blacklist_filter_ptr filter(new swd::blacklist_filter);
+    filter->set_impact(6);
+    filter->set_regex("foo");
+
+    swd::blacklist_filters filters;
+    filters.push_back(filter);
+    cache->set_blacklist_filters(filters);
+    cache->add_blacklist_rules(1, "qux", "bar", swd::blacklist_rules());
+    cache->add_blacklist_rules(1, "qux", "foo", swd::blacklist_rules());
+
+    swd::profile_ptr profile(new swd::profile);
+    profile->set_id(1);
+    profile->set_blacklist_threshold(5);
+
+    swd::request_ptr request(new swd::request);
+    request->set_caller("qux");
+    request->set_profile(profile);
+
+    swd::parameter_ptr parameter1(new swd::parameter);
+    parameter1->set_path("bar");
+    parameter1->set_value("<foo>");
+    request->add_parameter(parameter1);
+
+    swd::parameter_ptr parameter2(new swd::parameter);
+    parameter2->set_path("foo");
+    parameter2->set_value("baz");
+    request->add_parameter(parameter2);
+
+    blacklist.scan(request);
+    BOOST_CHECK(parameter1->get_blacklist_filters().size() == 1);
+    BOOST_CHECK(parameter1->is_threat() == true);
+    BOOST_CHECK(parameter2->get_blacklist_filters().size() == 1);
+    BOOST_CHECK(parameter2->is_threat() == true);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
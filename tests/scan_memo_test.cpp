@@ -0,0 +1,75 @@
+/**
+ * Shadow Daemon -- Web Application Firewall
+ *
+ *   Copyright (C) 2014-2022 Hendrik Buchwald <hb@zecure.org>
+ *
+ * This file is part of Shadow Daemon. Shadow Daemon is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, version 2.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include "scan_memo.h"
+
+BOOST_AUTO_TEST_SUITE(scan_memo_test)
+
+BOOST_AUTO_TEST_CASE(find_entry) {
+    swd::scan_memo scan_memo(1024);
+
+    std::vector<unsigned int> matches;
+    BOOST_CHECK(scan_memo.find(1, "foo", matches) == false);
+
+    scan_memo.add(1, "foo", {2, 3});
+    BOOST_CHECK(scan_memo.find(1, "foo", matches) == true);
+    BOOST_CHECK(matches.size() == 2);
+    BOOST_CHECK(matches[0] == 2);
+
+    /* Other strings and other generations are unknown. */
+    BOOST_CHECK(scan_memo.find(1, "bar", matches) == false);
+    BOOST_CHECK(scan_memo.find(2, "foo", matches) == false);
+}
+
+BOOST_AUTO_TEST_CASE(limit_entries) {
+    swd::scan_memo scan_memo(32);
+
+    for (int i = 0; i < 1000; i++) {
+        scan_memo.add(1, std::to_string(i), {});
+    }
+
+    BOOST_CHECK(scan_memo.get_size() <= 32);
+    BOOST_CHECK(scan_memo.get_size() > 0);
+}
+
+BOOST_AUTO_TEST_CASE(disabled) {
+    swd::scan_memo scan_memo(-1);
+
+    std::vector<unsigned int> matches;
+    scan_memo.add(1, "foo", {});
+    BOOST_CHECK(scan_memo.find(1, "foo", matches) == false);
+    BOOST_CHECK(scan_memo.get_size() == 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
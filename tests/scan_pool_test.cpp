@@ -0,0 +1,195 @@
+/**
+ * Shadow Daemon -- Web Application Firewall
+ *
+ *   Copyright (C) 2014-2022 Hendrik Buchwald <hb@zecure.org>
+ *
+ * This file is part of Shadow Daemon. Shadow Daemon is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, version 2.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+#include "scan_pool.h"
+#include "blacklist.h"
+
+BOOST_AUTO_TEST_SUITE(scan_pool_test)
+
+BOOST_AUTO_TEST_CASE(run_tasks) {
+    for (std::size_t threads: {0, 3}) {
+        swd::scan_pool scan_pool;
+        scan_pool.start(threads);
+
+        std::vector<int> results(100, 0);
+        scan_pool.run(results.size(), [&](std::size_t i) {
+            results[i] = (int) i * 2;
+        });
+
+        for (std::size_t i = 0; i < results.size(); i++) {
+            BOOST_CHECK(results[i] == (int) i * 2);
+        }
+
+        /* All tasks run even if one of them fails. */
+        std::atomic<int> executed{0};
+
+        BOOST_CHECK_THROW(scan_pool.run(10, [&](std::size_t i) {
+            ++executed;
+
+            if (i == 3) {
+                throw std::runtime_error("foo");
+            }
+        }), std::runtime_error);
+
+        BOOST_CHECK(executed == 10);
+
+        scan_pool.stop();
+    }
+}
+
+BOOST_AUTO_TEST_CASE(should_split) {
+    swd::scan_pool scan_pool;
+    scan_pool.set_threshold(10);
+
+    swd::parameters parameters;
+
+    for (int i = 0; i < 2; i++) {
+        swd::parameter_ptr parameter(new swd::parameter);
+        parameter->set_path("bar");
+        parameter->set_value("foo");
+        parameters.push_back(parameter);
+    }
+
+    /* Without helpers there is nothing to split. */
+    BOOST_CHECK(scan_pool.should_split(parameters) == false);
+
+    scan_pool.start(1);
+    BOOST_CHECK(scan_pool.should_split(parameters) == true);
+
+    scan_pool.set_threshold(13);
+    BOOST_CHECK(scan_pool.should_split(parameters) == false);
+
+    scan_pool.set_threshold(-1);
+    BOOST_CHECK(scan_pool.should_split(parameters) == false);
+
+    /* A single large parameter is split as well. */
+    parameters.pop_back();
+    scan_pool.set_threshold(6);
+    BOOST_CHECK(scan_pool.should_split(parameters) == true);
+
+    scan_pool.stop();
+}
+
+BOOST_AUTO_TEST_CASE(split_blacklist_check) {
+    swd::cache_ptr cache(new swd::cache(swd::database_ptr()));
+    swd::scan_pool_ptr scan_pool(new swd::scan_pool);
+    scan_pool->set_threshold(0);
+    scan_pool->start(2);
+
+    swd::blacklist blacklist(cache, true, scan_pool);
+
+    swd::blacklist_filter_ptr filter(new swd::blacklist_filter);
+    filter->set_impact(6);
+    filter->set_regex("foo");
+
+    swd::blacklist_filters filters;
+    filters.push_back(filter);
+    cache->set_blacklist_filters(filters);
+    cache->add_blacklist_rules(1, "qux", "bar", swd::blacklist_rules());
+
+    swd::profile_ptr profile(new swd::profile);
+    profile->set_id(1);
+    profile->set_blacklist_threshold(5);
+
+    swd::request_ptr request(new swd::request);
+    request->set_caller("qux");
+    request->set_profile(profile);
+
+    for (int i = 0; i < 50; i++) {
+        swd::parameter_ptr parameter(new swd::parameter);
+        parameter->set_path("bar");
+        parameter->set_value((i % 2) ? "foo" : "baz");
+        request->add_parameter(parameter);
+    }
+
+    blacklist.scan(request);
+
+    const swd::parameters& parameters = request->get_parameters();
+
+    for (std::size_t i = 0; i < parameters.size(); i++) {
+        BOOST_CHECK(parameters[i]->get_blacklist_filters().size() == (i % 2));
+        BOOST_CHECK(parameters[i]->is_threat() == (bool) (i % 2));
+    }
+
+    scan_pool->stop();
+}
+
+BOOST_AUTO_TEST_CASE(split_filters_blacklist_check) {
+    swd::cache_ptr cache(new swd::cache(swd::database_ptr()));
+    swd::scan_pool_ptr scan_pool(new swd::scan_pool);
+    scan_pool->set_threshold(0);
+    scan_pool->start(2);
+
+    swd::blacklist blacklist(cache, true, scan_pool);
+
+    swd::blacklist_filters filters;
+    std::string regexes[] = {"foo", "bar", "qux", "<script"};
+
+    for (const auto& regex: regexes) {
+        swd::blacklist_filter_ptr filter(new swd::blacklist_filter);
+        filter->set_impact(3);
+        filter->set_regex(regex);
+        filters.push_back(filter);
+    }
+
+    cache->set_blacklist_filters(filters);
+    cache->add_blacklist_rules(1, "qux", "bar", swd::blacklist_rules());
+
+    swd::profile_ptr profile(new swd::profile);
+    profile->set_id(1);
+    profile->set_blacklist_threshold(5);
+
+    swd::request_ptr request(new swd::request);
+    request->set_caller("qux");
+    request->set_profile(profile);
+
+    /* The only parameter is scanned by all filters in parallel. */
+    swd::parameter_ptr parameter(new swd::parameter);
+    parameter->set_path("bar");
+    parameter->set_value(std::string(10000, 'a') + "<SCRIPT" + std::string(10000, 'a'));
+    request->add_parameter(parameter);
+
+    blacklist.scan(request);
+
+    BOOST_CHECK(parameter->get_blacklist_filters().size() == 2);
+    BOOST_CHECK(parameter->get_impact() == 6);
+    BOOST_CHECK(parameter->is_threat() == true);
+
+    scan_pool->stop();
+}
+
+BOOST_AUTO_TEST_SUITE_END()